@@ -1,18 +1,43 @@
 #include "raylib.h"
 #include "src/game/platformer.h"
+#include "src/systems/atlas.h"
+#include "src/systems/cooked.h"
 
-Texture txTiles = {0};
-Texture txPlayer = {0};
-Texture txObjects = {0};
+Texture txAtlas = {0};
+Rectangle atlasRegions[ATLAS_REGION_COUNT] = {0};
+
+// Indexed by AtlasRegion
+const char* atlasSheets[ATLAS_REGION_COUNT] = {
+	"assets/tiles.png",
+	"assets/nuget.png",
+	"assets/objects.png",
+};
 
 void LoadAssetsGame() {
-	txTiles = LoadTexture("assets/tiles.png");
-	txPlayer = LoadTexture("assets/nuget.png");
-	txObjects = LoadTexture("assets/objects.png");
+	// The atlas packed by make cook uploads as is, the sheets are only decoded and packed
+	// here when it wasn't cooked or a sheet was edited after cooking
+	Image cooked = {0};
+	if (IsCookedFileCurrent(COOKED_MANIFEST, COOKED_ATLAS)) {
+		cooked = LoadCookedImage(COOKED_ATLAS, atlasRegions, ATLAS_REGION_COUNT);
+	}
+	if (cooked.data != ((void*)0)) {
+		txAtlas = LoadTextureFromImage(cooked);
+		UnloadImage(cooked);
+		return;
+	}
+
+	Image images[ATLAS_REGION_COUNT];
+	for (int i = 0; i < ATLAS_REGION_COUNT; i++) {
+		images[i] = LoadImage(atlasSheets[i]);
+	}
+
+	txAtlas = LoadAtlasFromImages(images, ATLAS_REGION_COUNT, ATLAS_PADDING, atlasRegions);
+
+	for (int i = 0; i < ATLAS_REGION_COUNT; i++) {
+		UnloadImage(images[i]);
+	}
 }
 
 void UnloadAssetsGame() {
-	UnloadTexture(txTiles);
-	UnloadTexture(txPlayer);
-	UnloadTexture(txObjects);
-}
\ No newline at end of file
+	UnloadTexture(txAtlas);
+}
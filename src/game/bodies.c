@@ -0,0 +1,99 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+
+//-----------------------------------------------------------------------------------------
+
+void LoadBodies(Game* game, int capacity) {
+	Bodies* bodies = &game->bodies;
+
+	// One block for every array, each array is contiguous for the batch passes
+	bodies->capacity = capacity;
+	bodies->count = 0;
+	bodies->x = ArenaAlloc(&game->arena, (sizeof(float) * 6 + sizeof(uint8_t)) * capacity);
+	bodies->y = bodies->x + capacity;
+	bodies->vx = bodies->y + capacity;
+	bodies->vy = bodies->vx + capacity;
+	bodies->w = bodies->vy + capacity;
+	bodies->h = bodies->w + capacity;
+	bodies->flags = (uint8_t*)(bodies->h + capacity);
+}
+
+// Returns the new body's index or -1 if the pool is full
+int AddBody(Game* game, Rectangle frame, Vector2 velocity, uint8_t flags) {
+	Bodies* bodies = &game->bodies;
+	if (bodies->count >= bodies->capacity) {
+		return -1;
+	}
+
+	int i = bodies->count++;
+	bodies->x[i] = frame.x;
+	bodies->y[i] = frame.y;
+	bodies->w[i] = frame.width;
+	bodies->h[i] = frame.height;
+	bodies->vx[i] = velocity.x;
+	bodies->vy[i] = velocity.y;
+	bodies->flags[i] = flags;
+
+	return i;
+}
+
+// Swap-removes a body, the last body takes over its index
+void RemoveBody(Game* game, int index) {
+	Bodies* bodies = &game->bodies;
+	int last = --bodies->count;
+
+	bodies->x[index] = bodies->x[last];
+	bodies->y[index] = bodies->y[last];
+	bodies->w[index] = bodies->w[last];
+	bodies->h[index] = bodies->h[last];
+	bodies->vx[index] = bodies->vx[last];
+	bodies->vy[index] = bodies->vy[last];
+	bodies->flags[index] = bodies->flags[last];
+}
+
+void ClearBodies(Game* game) {
+	game->bodies.count = 0;
+}
+
+// Advances every body by one tick. Gravity is integrated for all bodies in one
+// branch-free pass, then each body is swept against the tiles with the same
+// MoveBoxX/Y as the player. Bodies that fall out of the world are removed
+void StepBodies(Game* game) {
+	Bodies* bodies = &game->bodies;
+	int count = bodies->count;
+
+	float* restrict vy = bodies->vy;
+	const uint8_t* restrict flags = bodies->flags;
+	for (int i = 0; i < count; i++) {
+		float v = vy[i] + GRAVITY * (float)((flags[i] & BODY_GRAVITY) != 0);
+		vy[i] = v > BODY_MAX_FALL ? BODY_MAX_FALL : v;
+	}
+
+	const float killY = game->height * TILESIZE;
+	for (int i = 0; i < bodies->count;) {
+		Rectangle box = {bodies->x[i], bodies->y[i], bodies->w[i], bodies->h[i]};
+		float vx = bodies->vx[i];
+
+		TileHit hitX = MoveBoxX(game, &box, &vx);
+		if (hitX.hit && (bodies->flags[i] & BODY_BOUNCE)) {
+			vx = -bodies->vx[i]; // patrol back the other way
+		}
+
+		TileHit hitY = MoveBoxY(game, &box, &bodies->vy[i]);
+		if (hitY.hit && hitY.normal.y < 0.0f) {
+			bodies->flags[i] |= BODY_GROUNDED;
+		} else {
+			bodies->flags[i] &= ~BODY_GROUNDED;
+		}
+
+		if (box.y > killY) {
+			RemoveBody(game, i);
+			continue; // the swapped in body still needs stepping
+		}
+
+		bodies->x[i] = box.x;
+		bodies->y[i] = box.y;
+		bodies->vx[i] = vx;
+		i++;
+	}
+}
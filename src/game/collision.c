@@ -0,0 +1,153 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+
+#include <math.h>
+
+// Slack when locating the grid line a face is about to cross, so a box resting
+// exactly on (or a hair inside) a tile edge still registers that edge at time 0
+#define SWEEP_EPSILON 0.001f
+
+//-----------------------------------------------------------------------------------------
+
+static bool IsTileSolid(Game* game, int x, int y) {
+	// The ring has already recycled everything left of originX, treat it as a wall
+	if (game->endless && x < game->originX) {
+		return true;
+	}
+	if (!IsTileInBounds(game, x, y)) {
+		return false;
+	}
+
+	int col = x & game->wrapMask;
+	return (game->solid[y * game->solidStride + (col >> 5)] >> (col & 31)) & 1;
+}
+
+// Tiles overlapping the open interval (min, max), touching edges don't count
+static void GetCellSpan(float min, float max, int* first, int* last) {
+	*first = (int)floorf((min + SWEEP_EPSILON) / TILESIZE);
+	*last = (int)ceilf((max - SWEEP_EPSILON) / TILESIZE) - 1;
+}
+
+// Sets up stepping along one axis for a face at lead moving by delta:
+// time of the first grid line crossing, time between crossings and the first cell entered
+static void InitAxis(float lead, float delta, float* tNext, float* tStep, int* cell) {
+	if (delta > 0.0f) {
+		float line = ceilf((lead - SWEEP_EPSILON) / TILESIZE) * TILESIZE;
+		*tNext = (line - lead) / delta;
+		*tStep = TILESIZE / delta;
+		*cell = (int)(line / TILESIZE);
+	} else if (delta < 0.0f) {
+		float line = floorf((lead + SWEEP_EPSILON) / TILESIZE) * TILESIZE;
+		*tNext = (line - lead) / delta;
+		*tStep = TILESIZE / -delta;
+		*cell = (int)(line / TILESIZE) - 1;
+	} else {
+		*tNext = INFINITY;
+		*tStep = INFINITY;
+		*cell = 0;
+	}
+
+	if (*tNext < 0.0f) {
+		*tNext = 0.0f;
+	}
+}
+
+// Moves box along motion through the tile grid and reports the first solid tile it would enter.
+// Walks grid lines in time order like a DDA, only visiting the cells the leading faces sweep,
+// so the cost depends on distance travelled in tiles, never on map size.
+// A box already overlapping a tile is not pushed out, only entering a tile counts
+TileHit SweepTilemap(Game* game, Rectangle box, Vector2 motion) {
+	TileHit hit = {.time = 1.0f};
+
+	float tNextX, tStepX, tNextY, tStepY;
+	int cellX, cellY;
+	InitAxis(motion.x > 0.0f ? box.x + box.width : box.x, motion.x, &tNextX, &tStepX, &cellX);
+	InitAxis(motion.y > 0.0f ? box.y + box.height : box.y, motion.y, &tNextY, &tStepY, &cellY);
+
+	int stepX = motion.x > 0.0f ? 1 : -1;
+	int stepY = motion.y > 0.0f ? 1 : -1;
+
+	while (tNextX <= 1.0f || tNextY <= 1.0f) {
+		if (tNextX <= tNextY) {
+			// leading vertical face enters column cellX, check the rows it spans at that time
+			float t = tNextX;
+			int first, last;
+			GetCellSpan(box.y + motion.y * t, box.y + box.height + motion.y * t, &first, &last);
+
+			for (int y = first; y <= last; y++) {
+				if (IsTileSolid(game, cellX, y)) {
+					hit = (TileHit){t, (Vector2){(float)-stepX, 0.0f}, cellX, y, true};
+					return hit;
+				}
+			}
+
+			cellX += stepX;
+			tNextX += tStepX;
+		} else {
+			// leading horizontal face enters row cellY, check the columns it spans at that time
+			float t = tNextY;
+			int first, last;
+			GetCellSpan(box.x + motion.x * t, box.x + box.width + motion.x * t, &first, &last);
+
+			// Clip to resident columns, then test the whole span against the bitset at once
+			if (first < game->originX) {
+				first = game->originX;
+			}
+			if (last >= game->originX + game->width) {
+				last = game->originX + game->width - 1;
+			}
+
+			for (int x0 = first; cellY >= 0 && cellY < game->height && x0 <= last; x0 += 32) {
+				int x1 = last - x0 < 32 ? last : x0 + 31;
+				uint32_t solidBits = GetSolidSpan(game, x0, x1, cellY);
+				if (solidBits != 0) {
+					hit = (TileHit){t, (Vector2){0.0f, (float)-stepY}, x0 + __builtin_ctz(solidBits), cellY, true};
+					return hit;
+				}
+			}
+
+			cellY += stepY;
+			tNextY += tStepY;
+		}
+	}
+
+	return hit;
+}
+
+// Moves box by *velocity along x, stopping flush against the first tile in the way.
+// The snap is computed from the tile edge exactly so the next sweep starts on the grid line.
+// Velocity is zeroed on contact
+TileHit MoveBoxX(Game* game, Rectangle* box, float* velocity) {
+	TileHit hit = SweepTilemap(game, *box, (Vector2){*velocity, 0.0f});
+	if (!hit.hit) {
+		box->x += *velocity;
+		return hit;
+	}
+
+	if (*velocity > 0) {
+		box->x = hit.tileX * TILESIZE - box->width;
+	} else {
+		box->x = (hit.tileX + 1) * TILESIZE;
+	}
+	*velocity = 0;
+
+	return hit;
+}
+
+// Same as MoveBoxX along y, a hit with normal.y < 0 means the box landed
+TileHit MoveBoxY(Game* game, Rectangle* box, float* velocity) {
+	TileHit hit = SweepTilemap(game, *box, (Vector2){0.0f, *velocity});
+	if (!hit.hit) {
+		box->y += *velocity;
+		return hit;
+	}
+
+	if (*velocity > 0) {
+		box->y = hit.tileY * TILESIZE - box->height; // Snap to top of tile
+	} else {
+		box->y = (hit.tileY + 1) * TILESIZE; // Snap below tile
+	}
+	*velocity = 0;
+
+	return hit;
+}
@@ -1,21 +1,148 @@
 #include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
 #include "src/game/platformer.h"
 
 #include <math.h>
-#include "lib/stb_perlin.h"
-#include <stdlib.h>
+#include "src/systems/noise.h"
+#include "src/systems/rng.h"
 #include <time.h>
 
 //-----------------------------------------------------------------------------------------
 
+// procedural terrain parameters
+static const float freq = 0.06f;		// Perlin frequency (controls horizontal stretch)
+static const float amp = 8.0f;			// Perlin amplitude (vertical variation)
+static const int baseline_offset = 12;	// how many tiles from bottom is baseline ground
+static const float coin_chance = 0.05f; // chance to spawn a coin block at a column
+static const float hole_chance = 0.05f; // chance to start a short hole
+static const int max_hole_len = 4;		// max consecutive hole columns
+static const int noise_octaves = 1;		// fBm octaves, more adds small bumps on the surface
+
+//-----------------------------------------------------------------------------------------
+
+// true if world tile (x, y) is currently resident in the tilemap
+bool IsTileInBounds(Game* game, int x, int y) {
+	return x >= game->originX && x < game->originX + game->width && y >= 0 && y < game->height;
+}
+
 Tile* GetTileAt(Game* game, int x, int y) {
-	if (x < 0 || x >= game->width || y < 0 || y >= game->height) {
+	if (!IsTileInBounds(game, x, y)) {
 		static Tile noneTile = {0}; // sentinel returned for out-of-bounds
 		noneTile.id = TILE_ID_NONE;
 		return &noneTile;
 	}
 
-	return &game->tilemap[y * game->width + x];
+	return &game->tilemap[TILE_INDEX(game, x, y)];
+}
+
+// Writes a tile id and its solidity bit only, autotiling and the mesh are left untouched.
+// Used by generation which rebuilds those in bulk afterwards
+void WriteTileAt(Game* game, int x, int y, int id) {
+	if (!IsTileInBounds(game, x, y)) {
+		return;
+	}
+
+	int col = x & game->wrapMask;
+	uint32_t bit = 1u << (col & 31);
+	uint32_t* word = &game->solid[y * game->solidStride + (col >> 5)];
+
+	game->tilemap[TILE_INDEX(game, x, y)].id = id;
+	if (id != TILE_ID_NONE) {
+		*word |= bit;
+	} else {
+		*word &= ~bit;
+	}
+}
+
+// Changes a tile during play and records it in the level's edit log,
+// which is what snapshots store instead of the tilemap
+void SetTileAt(Game* game, int x, int y, int id) {
+	if (!IsTileInBounds(game, x, y)) {
+		return;
+	}
+
+	if (game->tileEditCount < game->tileEditLimit) {
+		game->tileEdits[game->tileEditCount++] = (TileEdit){x, y, game->tilemap[TILE_INDEX(game, x, y)].id, id};
+	} else {
+		game->tileEditsOverflowed = true;
+	}
+
+	RestoreTileAt(game, x, y, id);
+}
+
+// Changes a tile without recording it, for undoing and redoing recorded edits.
+// Schedules its quad for upload along with its four neighbours, whose autotile
+// direction may change. The level's tile hash swaps the old tile for the new one,
+// so it only depends on which tiles differ from the level's start, not on the order
+void RestoreTileAt(Game* game, int x, int y, int id) {
+	if (!IsTileInBounds(game, x, y)) {
+		return;
+	}
+
+	game->tileHash ^= HashTile(x, y, game->tilemap[TILE_INDEX(game, x, y)].id) ^ HashTile(x, y, id);
+	WriteTileAt(game, x, y, id);
+	UpdateAutotileAt(game, x, y);
+
+	MarkTileRowsDirty(game, x - 1, y, y);
+	MarkTileRowsDirty(game, x, y - 1, y + 1);
+	MarkTileRowsDirty(game, x + 1, y, y);
+}
+
+// Rebuilds the whole solidity bitset from the tilemap, which must start out zeroed.
+// Whole words are packed 32 tiles at a time, which vectorizes
+void BuildSolidBits(Game* game) {
+	int words = game->width / 32;
+
+	for (int y = 0; y < game->height; y++) {
+		const Tile* tiles = &game->tilemap[y * game->width];
+		uint32_t* row = &game->solid[y * game->solidStride];
+		for (int w = 0; w < words; w++) {
+			uint32_t bits = 0;
+			for (int b = 0; b < 32; b++) {
+				bits |= (uint32_t)(tiles[w * 32 + b].id != TILE_ID_NONE) << b;
+			}
+			row[w] = bits;
+		}
+		for (int x = words * 32; x < game->width; x++) {
+			row[x >> 5] |= (uint32_t)(tiles[x].id != TILE_ID_NONE) << (x & 31);
+		}
+	}
+}
+
+// Solidity of resident world columns x0..x1 (at most 32 of them) in row y as a mask,
+// bit 0 is column x0. Reads whole bitset words so an empty row is rejected in one test
+uint32_t GetSolidSpan(Game* game, int x0, int x1, int y) {
+	const uint32_t* row = &game->solid[y * game->solidStride];
+	uint32_t result = 0;
+	int shift = 0;
+
+	// Endless storage widths are multiples of 32 so a word never straddles the ring seam
+	for (int x = x0; x <= x1;) {
+		int col = x & game->wrapMask;
+		int bit = col & 31;
+		int count = 32 - bit;
+		if (count > x1 - x + 1) {
+			count = x1 - x + 1;
+		}
+
+		uint32_t word = row[col >> 5] >> bit;
+		if (count < 32) {
+			word &= (1u << count) - 1;
+		}
+
+		result |= word << shift;
+		shift += count;
+		x += count;
+	}
+
+	return result;
+}
+
+// Generation reads the tilemap directly like this, never through GetTileAt's shared
+// sentinel, since it also runs on the prefetch worker thread
+static bool IsTileFilled(Game* game, int x, int y) {
+	return IsTileInBounds(game, x, y) && game->tilemap[TILE_INDEX(game, x, y)].id != TILE_ID_NONE;
 }
 
 // returns which direction to auto tile,
@@ -23,10 +150,10 @@ Tile* GetTileAt(Game* game, int x, int y) {
 // 3, 4, 5,
 // 6, 7, 8,
 int GetTileDir(Game* game, int x, int y) {
-	bool up = GetTileAt(game, x, y - 1)->id != TILE_ID_NONE;
-	bool down = GetTileAt(game, x, y + 1)->id != TILE_ID_NONE;
-	bool left = GetTileAt(game, x - 1, y)->id != TILE_ID_NONE;
-	bool right = GetTileAt(game, x + 1, y)->id != TILE_ID_NONE;
+	bool up = IsTileFilled(game, x, y - 1);
+	bool down = IsTileFilled(game, x, y + 1);
+	bool left = IsTileFilled(game, x - 1, y);
+	bool right = IsTileFilled(game, x + 1, y);
 
 	if (!up && !left) {
 		return 0; // top-left
@@ -57,150 +184,277 @@ int GetTileDir(Game* game, int x, int y) {
 	return 4; // IT'S IN THE MIDDLE!
 }
 
+// Fills the autotile cache for every resident column, called once per level
+void BuildAutotileCache(Game* game) {
+	for (int y = 0; y < game->height; y++) {
+		for (int x = game->originX; x < game->originX + game->width; x++) {
+			game->autotile[TILE_INDEX(game, x, y)] = GetTileDir(game, x, y);
+		}
+	}
+}
+
+// Refreshes the cached direction of tile (x, y) and its 4 neighbours after it changed
+void UpdateAutotileAt(Game* game, int x, int y) {
+	const int offsets[5][2] = {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+	for (int i = 0; i < 5; i++) {
+		int nx = x + offsets[i][0];
+		int ny = y + offsets[i][1];
+		if (!IsTileInBounds(game, nx, ny)) {
+			continue;
+		}
+
+		game->autotile[TILE_INDEX(game, nx, ny)] = GetTileDir(game, nx, ny);
+	}
+}
+
 //-----------------------------------------------------------------------------------------
 // Draw Functions
 //-----------------------------------------------------------------------------------------
 
 void DrawGameTilemap(Game* game) {
-	// Convert screen corners to world coordinates (accounts for camera.offset and camera.zoom)
-	Vector2 worldTopLeft = GetScreenToWorld2D((Vector2){0.0f, 0.0f}, game->camera);
-	Vector2 worldBottomRight = GetScreenToWorld2D((Vector2){(float)GetScreenWidth(), (float)GetScreenHeight()}, game->camera);
+	// The mesh is drawn immediately, flush anything already queued in the batch first
+	// so draw order is kept. Off-screen quads are clipped by the GPU
+	rlDrawRenderBatchActive();
+	DrawMesh(game->tileMesh.mesh, game->tileMesh.material, MatrixIdentity());
+}
 
-	// Compute tile index range, add 1 tile padding to handle partial tiles at edges
-	int startX = (int)floorf(worldTopLeft.x / TILESIZE) - 1;
-	int endX = (int)floorf(worldBottomRight.x / TILESIZE) + 1;
-	int startY = (int)floorf(worldTopLeft.y / TILESIZE) - 1;
-	int endY = (int)floorf(worldBottomRight.y / TILESIZE) + 1;
+//-----------------------------------------------------------------------------------------
+// Generation
+//-----------------------------------------------------------------------------------------
 
-	// Clamp to map bounds
-	if (startX < 0) {
-		startX = 0;
+// Generates a single terrain column at world column x from its noise sample n [-1..1],
+// autotiling is left to the caller
+static void GenerateLevelColumn(Game* game, int x, float n) {
+	// compute a smooth surface from the noise
+	float baseline = (float)game->height - baseline_offset;
+	int surfaceY = (int)roundf(baseline + n * amp);
+
+	// clamp surface
+	if (surfaceY < 1) {
+		surfaceY = 1;
 	}
-	if (startY < 0) {
-		startY = 0;
+	if (surfaceY > game->height - 1) {
+		surfaceY = game->height - 1;
 	}
-	if (endX >= game->width) {
-		endX = game->width;
+
+	// maybe start a hole
+	if (game->holeRun == 0 && NextRngFloat(&game->rng) < hole_chance) {
+		game->holeRun = 1 + NextRngRange(&game->rng, max_hole_len);
 	}
-	if (endY >= game->height) {
-		endY = game->height;
+	if (game->holeRun > 0) {
+		// make this column a hole by pushing surface down off-map
+		surfaceY = game->height; // no ground this column
+		game->holeRun--;
 	}
 
-	for (int y = startY; y < endY; y++) {
-		for (int x = startX; x < endX; x++) {
-			Tile tile = *GetTileAt(game, x, y);
+	// fill tiles for this column
+	for (int y = 0; y < game->height; y++) {
+		// below surface = ground
+		bool placeable = y >= surfaceY && y < game->height;
+
+		if (placeable) {
+			WriteTileAt(game, x, y, TILE_ID_GROUND);
+		} else {
+			WriteTileAt(game, x, y, TILE_ID_NONE);
+		}
+
+		if (placeable && (x == 3 || x == game->width - 3)) {
+			WriteTileAt(game, x, y, TILE_ID_GROUND);
+		}
+	}
 
-			if (tile.id == TILE_ID_NONE) {
-				continue;
+	// Occasionally place a coin block in the air a few tiles above the surface
+	if (surfaceY > 3 && NextRngFloat(&game->rng) < coin_chance) {
+		int blockY = surfaceY - 4 - NextRngRange(&game->rng, 2); // 3-4 tiles above surface
+		if (blockY >= 0 && blockY < game->height) {
+			if (!IsTileFilled(game, x, blockY)) {
+				WriteTileAt(game, x, blockY, TILE_ID_BLOCK);
 			}
+		}
+	}
+}
 
-			int tileVariant = 3 * (tile.id - 1);
-			int tileDir = GetTileDir(game, x, y);
-			Rectangle tileSrcRec = {
-				(tileVariant + (tileDir % 3)) * TILESIZE,
-				(int)(tileDir / 3) * TILESIZE,
-				TILESIZE,
-				TILESIZE,
-			};
+// Generates count columns from world column x0, the surface noise for a whole
+// span is evaluated in one batch call
+static void GenerateLevelColumns(Game* game, int x0, int count) {
+	const NoiseParams noise = {(uint32_t)game->seed, noise_octaves, 2.0f, 0.5f};
+	float heights[64];
 
-			DrawTextureRec(txTiles, tileSrcRec, (Vector2){x * TILESIZE, y * TILESIZE}, WHITE);
+	for (int i = 0; i < count; i += 64) {
+		int n = count - i < 64 ? count - i : 64;
+		NoiseFbmRow(heights, n, (x0 + i) * freq, freq, 0.0f, game->noiseZ, noise);
+
+		for (int j = 0; j < n; j++) {
+			GenerateLevelColumn(game, x0 + i + j, heights[j]);
 		}
 	}
 }
 
+// Seed for the level after the current one, from the clock for variability,
+// mixed with the level so two levels started within the same second still differ.
+// Seeded games chain it from the current seed instead, so a session can be regenerated
+uint64_t NextLevelSeed(Game* game) {
+	if (game->seededLevels) {
+		return HashBytes(&game->seed, sizeof(game->seed), game->level);
+	}
+
+	uint64_t now = (uint64_t)time(NULL);
+	return HashBytes(&now, sizeof(now), game->level);
+}
+
 void NewLevel(Game* game) {
-	// clear objects
-	for (int i = 0; i < game->objectCount; i++) {
-		game->objects[i] = (Object){0};
-	}
-
-	// procedural terrain parameters
-	const float freq = 0.06f;		 // Perlin frequency (controls horizontal stretch)
-	const float amp = 8.0f;			 // Perlin amplitude (vertical variation)
-	const int baseline_offset = 12;	 // how many tiles from bottom is baseline ground
-	const float coin_chance = 0.05f; // chance to spawn a coin block at a column
-	const float hole_chance = 0.05f; // chance to start a short hole
-	const int max_hole_len = 4;		 // max consecutive hole columns
-
-	// seed RNG for variability
-	srand((unsigned)time(NULL));
-	float seed_z = (float)(rand() % 1000) / 1000.0f;
-
-	int holeRun = 0;
-
-	// generate column-by-column
-	for (int x = 0; x < game->width; x++) {
-		// compute a smooth surface using Perlin noise
-		float n = stb_perlin_noise3(x * freq, 0.0f, seed_z, 0, 0, 0); // [-1..1]
-		float baseline = (float)game->height - baseline_offset;
-		int surfaceY = (int)roundf(baseline + n * amp);
-
-		// clamp surface
-		if (surfaceY < 1) {
-			surfaceY = 1;
-		}
-		if (surfaceY > game->height - 1) {
-			surfaceY = game->height - 1;
-		}
+	// Use the level pre-generated in the background when there is one
+	if (SwapPrefetchedLevel(game)) {
+		return;
+	}
 
-		// maybe start a hole
-		if (holeRun == 0 && ((float)rand() / (float)RAND_MAX) < hole_chance) {
-			holeRun = 1 + (rand() % max_hole_len);
-		}
-		if (holeRun > 0) {
-			// make this column a hole by pushing surface down off-map
-			surfaceY = game->height; // no ground this column
-			holeRun--;
-		}
+	NewLevelWithSeed(game, NextLevelSeed(game));
+}
 
-		// fill tiles for this column
-		for (int y = 0; y < game->height; y++) {
-			Tile* tile = GetTileAt(game, x, y);
-			// below surface = ground
-			bool placeable = y >= surfaceY && y < game->height;
-
-			if (placeable) {
-				tile->id = TILE_ID_GROUND;
-			} else {
-				tile->id = TILE_ID_NONE;
-			}
+// Generates a level that only depends on seed and the map size
+void NewLevelWithSeed(Game* game, uint64_t seed) {
+	GenerateLevel(game, seed);
 
-			if (placeable && (x == 3 || x == game->width - 3)) {
-				tile->id = TILE_ID_GROUND;
-			}
+	// Every column of the mesh needs rewriting for the new terrain
+	MarkAllTilesDirty(game);
+	StartGeneratedLevel(game);
+}
+
+// Moves the player into a level whose tiles and objects are already generated
+void StartGeneratedLevel(Game* game) {
+	game->tileEditCount = 0;
+	game->tileEditsOverflowed = false;
+	game->tileHash = 0;
+	ClearBodies(game);
+	ClearParticles(game);
+	game->level++;
+	ResetPlayer(game->player, game);
+}
+
+// Carves the level's buffers out of the level arena after resetting it. Without a
+// chained block in between they land on the same addresses, a new level allocates nothing.
+// Without tileLayers the tile layers are left for a level file to provide
+void LoadLevelBuffers(Game* game, bool tileLayers) {
+	Arena* arena = &game->levelArena;
+	ResetArena(arena);
+	UnloadLevelFile(game);
+
+	if (tileLayers) {
+		game->tilemap = ArenaAlloc(arena, sizeof(Tile) * game->width * game->height);
+		game->autotile = ArenaAlloc(arena, sizeof(unsigned char) * game->width * game->height);
+		game->solid = ArenaAlloc(arena, sizeof(uint32_t) * game->solidStride * game->height);
+	}
+	game->objects = ArenaAlloc(arena, sizeof(Object) * game->objectLimit);
+	game->objectNextFree = ArenaAlloc(arena, sizeof(int) * game->objectLimit);
+	LoadObjectGrid(&game->objectGrid, arena, game->objectLimit);
+	ClearGameObjects(game);
+}
+
+// Fills the tilemap, its caches and the object list from seed. Only touches level data,
+// never the player, the mesh or GPU state, so it can run on a shadow game on a worker thread
+void GenerateLevel(Game* game, uint64_t seed) {
+	LoadLevelBuffers(game, true);
+
+	game->seed = seed;
+	SeedRng(&game->rng, seed);
+	game->noiseZ = NextRngRange(&game->rng, 1000) / 1000.0f;
+	game->holeRun = 0;
+
+	// generate column-by-column, endless mode starts over at world column 0
+	game->originX = 0;
+	GenerateLevelColumns(game, 0, game->width);
+	game->generatedX = game->width;
+
+	if (!game->endless) {
+		// place a door object near the far right, on the surface there
+		int doorX = game->width - 3;
+		if (doorX < 0) {
+			doorX = 0;
 		}
 
-		// Occasionally place a coin block in the air a few tiles above the surface
-		if (surfaceY > 3 && ((float)rand() / (float)RAND_MAX) < coin_chance) {
-			int blockY = surfaceY - 4 - (rand() % 2); // 3-4 tiles above surface
-			if (blockY >= 0 && blockY < game->height) {
-				Tile* blockTile = GetTileAt(game, x, blockY);
-				if (blockTile->id == TILE_ID_NONE) {
-					blockTile->id = TILE_ID_BLOCK;
-				}
+		// determine the door's surface Y (search upward for first non-none ground tile),
+		// over a hole it stands on the bottom edge. It is kept inside the map so saved levels load
+		int doorSurface = game->height - 2;
+		for (int y = 0; y < game->height; y++) {
+			if (game->tilemap[TILE_INDEX(game, doorX, y)].id == TILE_ID_GROUND) {
+				doorSurface = y - 2;
+				break;
 			}
 		}
-	}
+		if (doorSurface < 0) {
+			doorSurface = 0;
+		}
 
-	// place a door object near the far right, on the surface there
-	int doorX = game->width - 3;
-	if (doorX < 0) {
-		doorX = 0;
+		// spawn the door
+		AddGameObject(game, (Object){.id = OBJECT_ID_DOOR, .x = doorX * TILESIZE, .y = doorSurface * TILESIZE, .w = 16, .h = 32.});
 	}
 
-	// determine the door's surface Y (search upward for first non-none ground tile)
-	int doorSurface = game->height - 1;
+	BuildAutotileCache(game);
+}
+
+// 64-bit hash of the resident tiles (in world column order) and the object list,
+// equal hashes mean equal levels regardless of where the ring currently starts
+uint64_t HashGameLevel(Game* game) {
+	uint64_t hash = HashBytes(&game->originX, sizeof(game->originX), game->height);
+
+	int first = game->originX & game->wrapMask; // storage column of originX
 	for (int y = 0; y < game->height; y++) {
-		if (GetTileAt(game, doorX, y)->id == TILE_ID_GROUND) {
-			doorSurface = y - 2;
-			break;
-		}
+		const Tile* row = &game->tilemap[y * game->width];
+		hash = HashBytes(&row[first], sizeof(Tile) * (game->width - first), hash);
+		hash = HashBytes(row, sizeof(Tile) * first, hash);
 	}
 
-	// find a free object slot and spawn the door
-	AddGameObject(game, (Object){.id = OBJECT_ID_DOOR, .x = doorX * TILESIZE, .y = doorSurface * TILESIZE, .w = 16, .h = 32.});
+	return HashBytes(game->objects, sizeof(Object) * game->objectCount, hash);
+}
 
-	// Reset player
-	game->level++;
-	ResetPlayer(game->player, game->tilemap, (Vector2){game->width, game->height});
-}
\ No newline at end of file
+// Map sizes a game may be created with from a file
+bool IsLevelSizeValid(int width, int height) {
+	return width > 0 && height > 0 && width <= LEVEL_MAX_SIDE && height <= LEVEL_MAX_SIDE && (long long)width * height <= LEVEL_MAX_TILES;
+}
+
+// Hash of one tile of the level, XORed together these track the level's tile changes
+uint64_t HashTile(int x, int y, int id) {
+	int32_t tile[3] = {x, y, id};
+	return HashBytes(tile, sizeof(tile), 0);
+}
+
+// Generates chunk columns ahead of the camera in endless mode,
+// each new chunk column overwrites the oldest one in the ring so memory stays constant
+void StreamEndlessWorld(Game* game) {
+	if (!game->endless) {
+		return;
+	}
+
+	Vector2 worldTopRight = GetScreenToWorld2D((Vector2){VIEW_WIDTH, 0.0f}, game->camera);
+	StreamEndlessWorldTo(game, (int)floorf(worldTopRight.x / TILESIZE) + CHUNKSIZE);
+}
+
+// Generates chunk columns until world column aheadX is resident
+void StreamEndlessWorldTo(Game* game, int aheadX) {
+	while (game->generatedX < aheadX) {
+		int chunkX = game->generatedX;
+
+		// Slide the resident window forward, freeing the oldest chunk column for reuse
+		game->generatedX += CHUNKSIZE;
+		game->originX = game->generatedX - game->width;
+
+		GenerateLevelColumns(game, chunkX, CHUNKSIZE);
+		for (int x = chunkX; x < game->generatedX; x++) {
+			MarkTileColumnDirty(game, x);
+		}
+
+		// Autotile the new columns plus both seams: the previous last column gained
+		// a right neighbour and the new first resident column lost its left one
+		for (int y = 0; y < game->height; y++) {
+			for (int x = chunkX - 1; x < game->generatedX; x++) {
+				if (IsTileInBounds(game, x, y)) {
+					game->autotile[TILE_INDEX(game, x, y)] = GetTileDir(game, x, y);
+				}
+			}
+			game->autotile[TILE_INDEX(game, game->originX, y)] = GetTileDir(game, game->originX, y);
+		}
+		MarkTileColumnDirty(game, chunkX - 1);
+		MarkTileColumnDirty(game, game->originX);
+	}
+}
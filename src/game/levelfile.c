@@ -0,0 +1,436 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// Native builds map level files and point the tile layers straight into the mapping.
+// Elsewhere the whole file is read once, on the web from the --embed-file assets
+#if !defined(__EMSCRIPTEN__) && !defined(_WIN32)
+#define LEVEL_FILE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// File layout: LevelFileHeader, the layer table, the object table, then each layer on a
+// LEVEL_FILE_ALIGN boundary. Raw layers have exactly the layout of the game's buffers so
+// they are used in place. The solidity bits are not stored, loading rebuilds them from the
+// tiles. Fields are stored in host order, like replays
+#define LEVEL_FILE_MAGIC "JDLV"
+#define LEVEL_FILE_VERSION 1
+#define LEVEL_FILE_ALIGN 16
+#define LEVEL_TILE_DIR_MAX 8 // GetTileDir picks one of 3x3 sheet cells
+
+typedef enum LevelLayerType {
+	LEVEL_LAYER_TILES,	  // Tile per cell, row-major
+	LEVEL_LAYER_AUTOTILE, // cached GetTileDir per cell, rebuilt on load when missing
+	LEVEL_LAYER_COUNT,
+} LevelLayerType;
+
+typedef enum LevelLayerEncoding {
+	LEVEL_ENCODING_RAW,
+	LEVEL_ENCODING_RLE, // (count, value) byte pairs, byte layers only
+} LevelLayerEncoding;
+
+typedef struct LevelFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t seed; // seeded games chain the next level from it
+	int32_t width;
+	int32_t height;
+	uint32_t objectCount;
+	uint32_t layerCount;
+} LevelFileHeader;
+
+typedef struct LevelFileLayer {
+	uint32_t type;
+	uint32_t encoding;
+	uint64_t offset; // from the start of the file
+	uint64_t size;	 // bytes stored
+} LevelFileLayer;
+
+typedef struct LevelFileObject {
+	int32_t id;
+	int32_t x, y, w, h;
+} LevelFileObject;
+
+//-----------------------------------------------------------------------------------------
+
+static size_t AlignLevelOffset(size_t offset) {
+	return (offset + LEVEL_FILE_ALIGN - 1) & ~(size_t)(LEVEL_FILE_ALIGN - 1);
+}
+
+// Bytes a layer takes in memory, which is also its raw size in the file
+static size_t GetLayerRawSize(Game* game, LevelLayerType type) {
+	size_t cells = (size_t)game->width * game->height;
+
+	switch (type) {
+	case LEVEL_LAYER_TILES:
+		return sizeof(Tile) * cells;
+	case LEVEL_LAYER_AUTOTILE:
+		return sizeof(unsigned char) * cells;
+	default:
+		return 0;
+	}
+}
+
+// Writes the runs of size bytes to out (2 * size bytes at worst), returns the encoded size
+static size_t EncodeRle(unsigned char* out, const unsigned char* in, size_t size) {
+	size_t length = 0;
+
+	for (size_t i = 0; i < size;) {
+		unsigned char value = in[i];
+		size_t run = 1;
+		while (run < 255 && i + run < size && in[i + run] == value) {
+			run++;
+		}
+
+		out[length++] = (unsigned char)run;
+		out[length++] = value;
+		i += run;
+	}
+
+	return length;
+}
+
+// Decoded length of a run list, SIZE_MAX if it is malformed
+static size_t GetRleLength(const unsigned char* in, size_t size) {
+	if (size % 2 != 0) {
+		return SIZE_MAX;
+	}
+
+	size_t length = 0;
+	for (size_t i = 0; i < size; i += 2) {
+		if (in[i] == 0) {
+			return SIZE_MAX;
+		}
+		length += in[i];
+	}
+
+	return length;
+}
+
+static void DecodeRle(unsigned char* out, const unsigned char* in, size_t size) {
+	for (size_t i = 0; i < size; i += 2) {
+		memset(out, in[i + 1], in[i]);
+		out += in[i];
+	}
+}
+
+// Largest value a raw layer holds, compiles to a vector max
+static unsigned char GetRawMaxValue(const unsigned char* bytes, size_t size) {
+	unsigned char max = 0;
+	for (size_t i = 0; i < size; i++) {
+		max = bytes[i] > max ? bytes[i] : max;
+	}
+
+	return max;
+}
+
+// Largest value of a run list, counts are skipped
+static unsigned char GetRleMaxValue(const unsigned char* in, size_t size) {
+	unsigned char max = 0;
+	for (size_t i = 1; i < size; i += 2) {
+		max = in[i] > max ? in[i] : max;
+	}
+
+	return max;
+}
+
+//-----------------------------------------------------------------------------------------
+// File data, writable so raw tile layers can be played on in place
+//-----------------------------------------------------------------------------------------
+
+static unsigned char* OpenLevelFileData(const char* fileName, size_t* size) {
+#ifdef LEVEL_FILE_MMAP
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0) {
+		TraceLog(LOG_WARNING, "LEVEL: [%s] Failed to open file", fileName);
+		return ((void*)0);
+	}
+
+	unsigned char* data = ((void*)0);
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		// Private mapping, changed tiles copy only their own pages and never reach the file
+		void* map = mmap(((void*)0), st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			data = map;
+			*size = st.st_size;
+		}
+	}
+	close(fd);
+
+	if (data == ((void*)0)) {
+		TraceLog(LOG_WARNING, "LEVEL: [%s] Failed to map file", fileName);
+	}
+	return data;
+#else
+	int dataSize = 0;
+	unsigned char* data = LoadFileData(fileName, &dataSize);
+	*size = dataSize;
+	return data;
+#endif
+}
+
+static void CloseLevelFileData(unsigned char* data, size_t size) {
+#ifdef LEVEL_FILE_MMAP
+	munmap(data, size);
+#else
+	UnloadFileData(data);
+#endif
+}
+
+// Releases the file the current level's layers point into, if it was loaded from one
+void UnloadLevelFile(Game* game) {
+	if (game->levelFile == ((void*)0)) {
+		return;
+	}
+
+	CloseLevelFileData(game->levelFile, game->levelFileSize);
+	game->levelFile = ((void*)0);
+	game->levelFileSize = 0;
+}
+
+//-----------------------------------------------------------------------------------------
+
+// Checks everything LoadLevelFile relies on before the current level is touched,
+// and fills layers with the table entry of each layer type present
+static bool CheckLevelFile(Game* game, const char* fileName, const unsigned char* data, size_t size, const LevelFileLayer** layers) {
+	const LevelFileHeader* header = (const LevelFileHeader*)data;
+	if (size < sizeof(LevelFileHeader) || memcmp(header->magic, LEVEL_FILE_MAGIC, 4) != 0 || header->version != LEVEL_FILE_VERSION) {
+		TraceLog(LOG_WARNING, "LEVEL: [%s] Not a version %d level file", fileName, LEVEL_FILE_VERSION);
+		return false;
+	}
+
+	if (game->endless || header->width != game->width || header->height != game->height || header->objectCount > (uint32_t)game->objectLimit) {
+		TraceLog(LOG_WARNING, "LEVEL: [%s] %dx%d level with %u objects doesn't fit this game", fileName, header->width, header->height,
+				 header->objectCount);
+		return false;
+	}
+
+	size_t tablesEnd = sizeof(LevelFileHeader) + header->layerCount * sizeof(LevelFileLayer) + header->objectCount * sizeof(LevelFileObject);
+	if (header->layerCount > LEVEL_LAYER_COUNT || tablesEnd > size) {
+		TraceLog(LOG_WARNING, "LEVEL: [%s] File is truncated", fileName);
+		return false;
+	}
+
+	const LevelFileLayer* table = (const LevelFileLayer*)(data + sizeof(LevelFileHeader));
+	for (uint32_t i = 0; i < header->layerCount; i++) {
+		const LevelFileLayer* layer = &table[i];
+
+		bool valid = layer->type < LEVEL_LAYER_COUNT && layers[layer->type] == ((void*)0) && layer->offset % LEVEL_FILE_ALIGN == 0 &&
+					 layer->offset <= size && layer->size <= size - layer->offset;
+		if (valid && layer->encoding == LEVEL_ENCODING_RAW) {
+			valid = layer->size == GetLayerRawSize(game, layer->type);
+		} else if (valid && layer->encoding == LEVEL_ENCODING_RLE) {
+			valid = GetRleLength(data + layer->offset, layer->size) == GetLayerRawSize(game, layer->type);
+		} else {
+			valid = false;
+		}
+
+		// Tile ids and directions index the tile sheet, every stored one must be in range
+		if (valid) {
+			const unsigned char* bytes = data + layer->offset;
+			unsigned char max = layer->encoding == LEVEL_ENCODING_RAW ? GetRawMaxValue(bytes, layer->size) : GetRleMaxValue(bytes, layer->size);
+			valid = max <= (layer->type == LEVEL_LAYER_TILES ? TILE_ID_BLOCK : LEVEL_TILE_DIR_MAX);
+		}
+
+		if (!valid) {
+			TraceLog(LOG_WARNING, "LEVEL: [%s] Layer %u is damaged", fileName, i);
+			return false;
+		}
+		layers[layer->type] = layer;
+	}
+
+	if (layers[LEVEL_LAYER_TILES] == ((void*)0)) {
+		TraceLog(LOG_WARNING, "LEVEL: [%s] File has no tile layer", fileName);
+		return false;
+	}
+
+	// Objects pick sprites by id and are indexed by the grid cells they overlap, each one
+	// must be a known kind no bigger than a cell and lie inside the map
+	const LevelFileObject* objects = (const LevelFileObject*)(data + sizeof(LevelFileHeader) + header->layerCount * sizeof(LevelFileLayer));
+	for (uint32_t i = 0; i < header->objectCount; i++) {
+		const LevelFileObject* obj = &objects[i];
+		if (obj->id <= OBJECT_ID_NONE || obj->id > OBJECT_ID_DOOR || obj->w <= 0 || obj->h <= 0 || obj->w > OBJECT_CELL_SIZE ||
+			obj->h > OBJECT_CELL_SIZE || obj->x < 0 || obj->y < 0 || (long long)obj->x + obj->w > (long long)game->width * TILESIZE ||
+			(long long)obj->y + obj->h > (long long)game->height * TILESIZE) {
+			TraceLog(LOG_WARNING, "LEVEL: [%s] Object %u is damaged", fileName, i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Raw layers are used in place, encoded ones are decoded into the level arena
+static void* LoadLevelLayer(Game* game, unsigned char* data, const LevelFileLayer* layer) {
+	if (layer == ((void*)0)) {
+		return ((void*)0);
+	}
+	if (layer->encoding == LEVEL_ENCODING_RAW) {
+		return data + layer->offset;
+	}
+
+	void* buffer = ArenaAlloc(&game->levelArena, GetLayerRawSize(game, layer->type));
+	DecodeRle(buffer, data + layer->offset, layer->size);
+	return buffer;
+}
+
+// Size of the level stored in a file, to create a game it fits in
+bool GetLevelFileSize(const char* fileName, int* width, int* height) {
+	size_t size = 0;
+	unsigned char* data = OpenLevelFileData(fileName, &size);
+	if (data == ((void*)0)) {
+		return false;
+	}
+
+	LevelFileHeader header;
+	bool valid = size >= sizeof(header);
+	if (valid) {
+		memcpy(&header, data, sizeof(header));
+		valid = memcmp(header.magic, LEVEL_FILE_MAGIC, 4) == 0 && header.version == LEVEL_FILE_VERSION;
+	}
+	CloseLevelFileData(data, size);
+
+	if (!valid) {
+		TraceLog(LOG_WARNING, "LEVEL: [%s] Not a version %d level file", fileName, LEVEL_FILE_VERSION);
+		return false;
+	}
+	if (!IsLevelSizeValid(header.width, header.height)) {
+		TraceLog(LOG_WARNING, "LEVEL: [%s] %dx%d is not a level size this game supports", fileName, header.width, header.height);
+		return false;
+	}
+
+	*width = header.width;
+	*height = header.height;
+	return true;
+}
+
+// Replaces the current level with one stored by SaveLevelFile, the map size must match.
+// Raw layers are used in place without copying or decoding any tile, they are only scanned
+// once for out of range values, objects are checked before any is added. Returns false and
+// keeps the current level if the file is unusable
+bool LoadLevelFile(Game* game, const char* fileName) {
+	size_t size = 0;
+	unsigned char* data = OpenLevelFileData(fileName, &size);
+	if (data == ((void*)0)) {
+		return false;
+	}
+
+	const LevelFileLayer* layers[LEVEL_LAYER_COUNT] = {0};
+	if (!CheckLevelFile(game, fileName, data, size, layers)) {
+		CloseLevelFileData(data, size);
+		return false;
+	}
+	const LevelFileHeader* header = (const LevelFileHeader*)data;
+
+	// Only objects come from the arena here, the level's layers live in the file
+	CancelLevelPrefetch(game); // it was seeded from the level being replaced
+	LoadLevelBuffers(game, false);
+	game->levelFile = data;
+	game->levelFileSize = size;
+
+	game->tilemap = LoadLevelLayer(game, data, layers[LEVEL_LAYER_TILES]);
+	game->solid = ArenaAlloc(&game->levelArena, sizeof(uint32_t) * game->solidStride * game->height);
+	BuildSolidBits(game);
+	game->autotile = LoadLevelLayer(game, data, layers[LEVEL_LAYER_AUTOTILE]);
+	if (game->autotile == ((void*)0)) {
+		game->autotile = ArenaAlloc(&game->levelArena, GetLayerRawSize(game, LEVEL_LAYER_AUTOTILE));
+		BuildAutotileCache(game);
+	}
+
+	const LevelFileObject* objects = (const LevelFileObject*)(data + sizeof(LevelFileHeader) + header->layerCount * sizeof(LevelFileLayer));
+	for (uint32_t i = 0; i < header->objectCount; i++) {
+		const LevelFileObject* obj = &objects[i];
+		AddGameObject(game, (Object){.id = obj->id, .x = obj->x, .y = obj->y, .w = obj->w, .h = obj->h});
+	}
+
+	game->seed = header->seed;
+	SeedRng(&game->rng, header->seed);
+	game->originX = 0;
+	game->generatedX = game->width;
+	game->holeRun = 0;
+
+	MarkAllTilesDirty(game);
+	StartGeneratedLevel(game);
+	return true;
+}
+
+//-----------------------------------------------------------------------------------------
+
+// Stores the current level. The default keeps the tile and autotile layers raw for in-place
+// loading, compact stores only the run-length encoded tiles and rebuilds the rest on load
+bool SaveLevelFile(Game* game, const char* fileName, bool compact) {
+	if (game->endless) {
+		TraceLog(LOG_WARNING, "LEVEL: [%s] Endless worlds have no fixed level to save", fileName);
+		return false;
+	}
+
+	int objectCount = 0;
+	for (int i = 0; i < game->objectCount; i++) {
+		objectCount += game->objects[i].id != OBJECT_ID_NONE; // skip tombstones
+	}
+
+	size_t cells = (size_t)game->width * game->height;
+	const unsigned char* sources[LEVEL_LAYER_COUNT] = {(const unsigned char*)game->tilemap, game->autotile};
+	unsigned char* runs = ((void*)0);
+
+	LevelFileLayer layers[LEVEL_LAYER_COUNT] = {0};
+	int layerCount = compact ? 1 : LEVEL_LAYER_COUNT;
+	if (compact) {
+		runs = MemAlloc(2 * cells);
+		layers[0] = (LevelFileLayer){.type = LEVEL_LAYER_TILES, .encoding = LEVEL_ENCODING_RLE, .size = EncodeRle(runs, sources[0], cells)};
+		sources[0] = runs;
+	} else {
+		for (int i = 0; i < layerCount; i++) {
+			layers[i] = (LevelFileLayer){.type = i, .encoding = LEVEL_ENCODING_RAW, .size = GetLayerRawSize(game, i)};
+		}
+	}
+
+	size_t size = sizeof(LevelFileHeader) + layerCount * sizeof(LevelFileLayer) + objectCount * sizeof(LevelFileObject);
+	for (int i = 0; i < layerCount; i++) {
+		layers[i].offset = AlignLevelOffset(size);
+		size = layers[i].offset + layers[i].size;
+	}
+
+	LevelFileHeader header = {
+		.magic = LEVEL_FILE_MAGIC,
+		.version = LEVEL_FILE_VERSION,
+		.seed = game->seed,
+		.width = game->width,
+		.height = game->height,
+		.objectCount = objectCount,
+		.layerCount = layerCount,
+	};
+
+	unsigned char* data = MemAlloc(size); // zeroed, so is the alignment padding
+	unsigned char* at = data;
+
+	memcpy(at, &header, sizeof(header));
+	at += sizeof(header);
+	memcpy(at, layers, sizeof(LevelFileLayer) * layerCount);
+	at += sizeof(LevelFileLayer) * layerCount;
+
+	for (int i = 0; i < game->objectCount; i++) {
+		Object* obj = &game->objects[i];
+		if (obj->id != OBJECT_ID_NONE) {
+			LevelFileObject stored = {obj->id, obj->x, obj->y, obj->w, obj->h};
+			memcpy(at, &stored, sizeof(stored));
+			at += sizeof(stored);
+		}
+	}
+
+	for (int i = 0; i < layerCount; i++) {
+		memcpy(data + layers[i].offset, sources[layers[i].type], layers[i].size);
+	}
+
+	bool success = SaveFileData(fileName, data, (int)size);
+	MemFree(data);
+	MemFree(runs);
+
+	return success;
+}
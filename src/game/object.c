@@ -1,43 +1,292 @@
 #include "raylib.h"
 #include "src/game/platformer.h"
 
-void AddGameObject(Game* game, Object object) {
-	if (game->objectCount >= game->objectLimit) {
-		return;
+#include <math.h>
+
+// Objects are bucketed by the OBJECT_CELL_SIZE cells they overlap. Cells hash into a
+// power-of-two bucket table so the grid works for unbounded (endless) worlds too
+#define CELL_HASH(cx, cy) (((unsigned int)(cx) * 73856093u) ^ ((unsigned int)(cy) * 19349663u))
+#define ENTRIES_PER_OBJECT 4 // AddGameObject refuses objects bigger than a cell, so none overlaps more than 4
+
+typedef bool (*ObjectVisitor)(Game* game, int index, void* user); // return false to stop
+
+//-----------------------------------------------------------------------------------------
+// Spatial grid
+//-----------------------------------------------------------------------------------------
+
+void LoadObjectGrid(ObjectGrid* grid, Arena* arena, int objectLimit) {
+	int bucketCount = 64;
+	while (bucketCount < objectLimit * 2) {
+		bucketCount <<= 1;
 	}
 
-	game->objects[game->objectCount++] = object;
+	grid->bucketMask = bucketCount - 1;
+	grid->buckets = ArenaAlloc(arena, sizeof(int) * bucketCount);
+	grid->bucketStamps = ArenaAlloc(arena, sizeof(unsigned int) * bucketCount);
+	grid->clearStamp = 0;
+	grid->entryLimit = objectLimit * ENTRIES_PER_OBJECT;
+	grid->entryObject = ArenaAlloc(arena, sizeof(int) * grid->entryLimit);
+	grid->entryCell = ArenaAlloc(arena, sizeof(unsigned int) * grid->entryLimit);
+	grid->entryNext = ArenaAlloc(arena, sizeof(int) * grid->entryLimit);
+	grid->marks = ArenaAlloc(arena, sizeof(unsigned int) * objectLimit);
+	grid->queryStamp = 0;
+
+	ClearObjectGrid(grid);
 }
 
-Object* GetObjectAt(Game* game, Rectangle hitbox) {
-	static Object emptyObj = (Object){0};
+// O(1), buckets stamped with an older clear are treated as empty when next touched
+void ClearObjectGrid(ObjectGrid* grid) {
+	grid->clearStamp++;
+	grid->entryCount = 0;
+	grid->freeEntry = -1;
+}
 
-	for (int i = 0; i < game->objectCount; i++) {
-		Object* obj = &game->objects[i];
-		if (obj->id == OBJECT_ID_NONE) {
-			continue;
+static int* GetGridBucket(ObjectGrid* grid, unsigned int cell) {
+	int bucket = cell & grid->bucketMask;
+	if (grid->bucketStamps[bucket] != grid->clearStamp) {
+		grid->bucketStamps[bucket] = grid->clearStamp;
+		grid->buckets[bucket] = -1;
+	}
+
+	return &grid->buckets[bucket];
+}
+
+// Cell range covered by a rectangle, inclusive
+static void GetCellRange(Rectangle rec, int* x0, int* y0, int* x1, int* y1) {
+	*x0 = (int)floorf(rec.x / OBJECT_CELL_SIZE);
+	*y0 = (int)floorf(rec.y / OBJECT_CELL_SIZE);
+	*x1 = (int)floorf((rec.x + rec.width) / OBJECT_CELL_SIZE);
+	*y1 = (int)floorf((rec.y + rec.height) / OBJECT_CELL_SIZE);
+}
+
+static Rectangle GetObjectRec(Object* obj) {
+	return (Rectangle){obj->x, obj->y, obj->w, obj->h};
+}
+
+static void InsertObjectInGrid(Game* game, int index) {
+	ObjectGrid* grid = &game->objectGrid;
+	int x0, y0, x1, y1;
+	GetCellRange(GetObjectRec(&game->objects[index]), &x0, &y0, &x1, &y1);
+
+	for (int cy = y0; cy <= y1; cy++) {
+		for (int cx = x0; cx <= x1; cx++) {
+			int entry = grid->freeEntry;
+			if (entry >= 0) {
+				grid->freeEntry = grid->entryNext[entry];
+			} else if (grid->entryCount < grid->entryLimit) {
+				entry = grid->entryCount++;
+			} else {
+				TraceLog(LOG_WARNING, "OBJECTS: Grid is out of entries, object %d is not fully indexed", index);
+				return;
+			}
+
+			unsigned int cell = CELL_HASH(cx, cy);
+			int* bucket = GetGridBucket(grid, cell);
+			grid->entryObject[entry] = index;
+			grid->entryCell[entry] = cell;
+			grid->entryNext[entry] = *bucket;
+			*bucket = entry;
 		}
+	}
+}
 
-		Rectangle rec = {obj->x, obj->y, obj->w, obj->h};
+static void RemoveObjectFromGrid(Game* game, int index) {
+	ObjectGrid* grid = &game->objectGrid;
+	int x0, y0, x1, y1;
+	GetCellRange(GetObjectRec(&game->objects[index]), &x0, &y0, &x1, &y1);
 
-		if (CheckCollisionRecs(rec, hitbox)) {
-			return obj;
+	for (int cy = y0; cy <= y1; cy++) {
+		for (int cx = x0; cx <= x1; cx++) {
+			int* link = GetGridBucket(grid, CELL_HASH(cx, cy));
+			while (*link >= 0) {
+				int entry = *link;
+				if (grid->entryObject[entry] == index) {
+					*link = grid->entryNext[entry];
+					grid->entryNext[entry] = grid->freeEntry;
+					grid->freeEntry = entry;
+					break;
+				}
+				link = &grid->entryNext[entry];
+			}
 		}
 	}
+}
+
+// Visits each object overlapping area once, only walking the buckets of the cells area covers
+static void ForEachObjectInRect(Game* game, Rectangle area, ObjectVisitor visitor, void* user) {
+	ObjectGrid* grid = &game->objectGrid;
+	int x0, y0, x1, y1;
+	GetCellRange(area, &x0, &y0, &x1, &y1);
+
+	// objects spanning several cells are reached several times, stamp them to visit once
+	unsigned int stamp = ++grid->queryStamp;
+
+	for (int cy = y0; cy <= y1; cy++) {
+		for (int cx = x0; cx <= x1; cx++) {
+			unsigned int cell = CELL_HASH(cx, cy);
 
-	return &emptyObj;
+			for (int entry = *GetGridBucket(grid, cell); entry >= 0; entry = grid->entryNext[entry]) {
+				int index = grid->entryObject[entry];
+				if (grid->entryCell[entry] != cell || grid->marks[index] == stamp) {
+					continue; // hash collision with another cell, or already visited
+				}
+				grid->marks[index] = stamp;
+
+				if (!CheckCollisionRecs(GetObjectRec(&game->objects[index]), area)) {
+					continue;
+				}
+				if (!visitor(game, index, user)) {
+					return;
+				}
+			}
+		}
+	}
 }
 
-void DrawGameObjects(Game* game) {
-	for (int i = 0; i < game->objectCount; i++) {
-		Object object = game->objects[i];
+//-----------------------------------------------------------------------------------------
+
+// Object pool
+//-----------------------------------------------------------------------------------------
 
-		if (object.id == OBJECT_ID_NONE) {
-			continue;
+// O(1), slots are reused lazily and their generation is bumped then, so handles
+// into the cleared level turn stale without touching every slot
+void ClearGameObjects(Game* game) {
+	game->objectCount = 0;
+	game->objectFreeHead = -1;
+	ClearObjectGrid(&game->objectGrid);
+}
+
+// Spawns an object into a free slot, returns OBJECT_HANDLE_NONE when the pool is full or the
+// object is bigger than a grid cell
+ObjectHandle AddGameObject(Game* game, Object object) {
+	if (object.w < 0 || object.h < 0 || object.w > OBJECT_CELL_SIZE || object.h > OBJECT_CELL_SIZE) {
+		TraceLog(LOG_WARNING, "OBJECTS: Object %d is %dx%d, over the %d pixel cell size, dropped", object.id, object.w, object.h, OBJECT_CELL_SIZE);
+		return OBJECT_HANDLE_NONE;
+	}
+
+	int index = game->objectFreeHead;
+	if (index >= 0) {
+		game->objectFreeHead = game->objectNextFree[index];
+	} else if (game->objectCount < game->objectLimit) {
+		index = game->objectCount++;
+	} else {
+		TraceLog(LOG_WARNING, "OBJECTS: Pool is full (%d objects), object %d dropped", game->objectLimit, object.id);
+		return OBJECT_HANDLE_NONE;
+	}
+
+	game->objectGenerations[index]++;
+	game->objects[index] = object;
+	InsertObjectInGrid(game, index);
+
+	return (ObjectHandle){index, game->objectGenerations[index]};
+}
+
+// Despawns the object and leaves a tombstone (id OBJECT_ID_NONE) for the free list,
+// does nothing for stale handles
+void RemoveGameObject(Game* game, ObjectHandle handle) {
+	if (GetGameObject(game, handle) == ((void*)0)) {
+		return;
+	}
+
+	RemoveObjectFromGrid(game, handle.index);
+	game->objects[handle.index] = (Object){0};
+	game->objectNextFree[handle.index] = game->objectFreeHead;
+	game->objectFreeHead = handle.index;
+}
+
+// Returns the object behind the handle, or NULL when it was removed or its level cleared
+Object* GetGameObject(Game* game, ObjectHandle handle) {
+	if (handle.index < 0 || handle.index >= game->objectCount || game->objectGenerations[handle.index] != handle.generation ||
+		game->objects[handle.index].id == OBJECT_ID_NONE) {
+		return ((void*)0);
+	}
+
+	return &game->objects[handle.index];
+}
+
+ObjectHandle GetObjectHandle(Game* game, Object* object) {
+	int index = (int)(object - game->objects);
+	if (index < 0 || index >= game->objectCount || object->id == OBJECT_ID_NONE) {
+		return OBJECT_HANDLE_NONE;
+	}
+
+	return (ObjectHandle){index, game->objectGenerations[index]};
+}
+
+// Indexes every live slot again, after the pool was overwritten wholesale
+void RebuildObjectGrid(Game* game) {
+	ClearObjectGrid(&game->objectGrid);
+	for (int i = 0; i < game->objectCount; i++) {
+		if (game->objects[i].id != OBJECT_ID_NONE) {
+			InsertObjectInGrid(game, i);
 		}
+	}
+}
+
+// Hands out fresh generations for every slot of a level generated in another pool,
+// so handles into the level it replaced are stale
+void RenewObjectGenerations(Game* game) {
+	for (int i = 0; i < game->objectCount; i++) {
+		game->objectGenerations[i]++;
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+// Queries
+//-----------------------------------------------------------------------------------------
 
-		Rectangle src = {(object.id - 1) * 16, 0, object.w, object.h};
-		Vector2 pos = {object.x, object.y};
-		DrawTextureRec(txObjects, src, pos, WHITE);
+typedef struct ObjectQuery {
+	int* out;
+	int maxOut;
+	int count;
+} ObjectQuery;
+
+static bool CollectObject(Game* game, int index, void* user) {
+	ObjectQuery* query = user;
+	query->out[query->count++] = index;
+	return query->count < query->maxOut;
+}
+
+// Writes the indices of up to maxOut objects overlapping area, returns how many were found
+int QueryObjectsInRect(Game* game, Rectangle area, int* out, int maxOut) {
+	ObjectQuery query = {out, maxOut, 0};
+	if (maxOut > 0) {
+		ForEachObjectInRect(game, area, CollectObject, &query);
+	}
+	return query.count;
+}
+
+Object* GetObjectAt(Game* game, Rectangle hitbox) {
+	static Object emptyObj = (Object){0};
+
+	int index;
+	if (QueryObjectsInRect(game, hitbox, &index, 1) == 0) {
+		return &emptyObj;
 	}
-}
\ No newline at end of file
+
+	return &game->objects[index];
+}
+
+Object* GetObjectAtPoint(Game* game, Vector2 point) {
+	return GetObjectAt(game, (Rectangle){point.x, point.y, 0.001f, 0.001f});
+}
+
+static bool DrawObject(Game* game, int index, void* user) {
+	Rectangle sheet = atlasRegions[ATLAS_REGION_OBJECTS];
+	Object object = game->objects[index];
+
+	Rectangle src = {sheet.x + (object.id - 1) * 16, sheet.y, object.w, object.h};
+	Vector2 pos = {object.x, object.y};
+	DrawTextureRec(txAtlas, src, pos, WHITE);
+
+	return true;
+}
+
+// Draws only the objects inside the camera's view
+void DrawGameObjects(Game* game, Camera2D camera) {
+	Vector2 worldTopLeft = GetScreenToWorld2D((Vector2){0.0f, 0.0f}, camera);
+	Vector2 worldBottomRight = GetScreenToWorld2D((Vector2){(float)GetScreenWidth(), (float)GetScreenHeight()}, camera);
+	Rectangle view = {worldTopLeft.x, worldTopLeft.y, worldBottomRight.x - worldTopLeft.x, worldBottomRight.y - worldTopLeft.y};
+
+	ForEachObjectInRect(game, view, DrawObject, ((void*)0));
+}
@@ -0,0 +1,167 @@
+#include "raylib.h"
+#include "rlgl.h"
+#include "src/game/platformer.h"
+
+#define PARTICLE_ARRAYS 7 // x, y, vx, vy, life, u, v
+
+//-----------------------------------------------------------------------------------------
+
+void LoadParticles(Game* game, int capacity) {
+	Particles* particles = &game->particles;
+
+	// One block for every array, like the bodies. Nothing is allocated after this
+	particles->capacity = capacity;
+	particles->count = 0;
+	particles->x = ArenaAlloc(&game->arena, sizeof(float) * PARTICLE_ARRAYS * capacity);
+	particles->y = particles->x + capacity;
+	particles->vx = particles->y + capacity;
+	particles->vy = particles->vx + capacity;
+	particles->life = particles->vy + capacity;
+	particles->u = particles->life + capacity;
+	particles->v = particles->u + capacity;
+
+	SeedRng(&particles->rng, 0x5EED);
+}
+
+void ClearParticles(Game* game) {
+	game->particles.count = 0;
+}
+
+// Spawns one PARTICLE_SIZE fragment cut from the atlas at (u, v), dropped when the pool is full
+static void EmitParticle(Particles* particles, float x, float y, float vx, float vy, float life, float u, float v) {
+	if (particles->count >= particles->capacity) {
+		return;
+	}
+
+	int i = particles->count++;
+	particles->x[i] = x;
+	particles->y[i] = y;
+	particles->vx[i] = vx;
+	particles->vy[i] = vy;
+	particles->life[i] = life;
+	particles->u[i] = u;
+	particles->v[i] = v;
+}
+
+// Atlas pixel of the centre piece of a tile's autotile set
+static Vector2 GetTileCentreSource(TileId id) {
+	Rectangle sheet = atlasRegions[ATLAS_REGION_TILES];
+	return (Vector2){sheet.x + (3 * (id - 1) + 1) * TILESIZE, sheet.y + TILESIZE};
+}
+
+// Bursts a broken tile into fragments of its own texture
+void EmitTileDebris(Game* game, int x, int y, TileId id) {
+	Particles* particles = &game->particles;
+	Vector2 source = GetTileCentreSource(id);
+	const int pieces = TILESIZE / PARTICLE_SIZE;
+
+	for (int py = 0; py < pieces; py++) {
+		for (int px = 0; px < pieces; px++) {
+			float ox = (float)(px * PARTICLE_SIZE);
+			float oy = (float)(py * PARTICLE_SIZE);
+			float vx = (ox - TILESIZE / 2.0f) * 0.15f + (NextRngFloat(&particles->rng) - 0.5f);
+			float vy = -2.0f - 2.0f * NextRngFloat(&particles->rng);
+
+			EmitParticle(particles, x * TILESIZE + ox, y * TILESIZE + oy, vx, vy, 0.8f + 0.4f * NextRngFloat(&particles->rng), source.x + ox,
+						 source.y + oy);
+		}
+	}
+}
+
+// Kicks up a few ground fragments on both sides of the feet
+void EmitLandingDust(Game* game, Vector2 feet) {
+	Particles* particles = &game->particles;
+	Vector2 source = GetTileCentreSource(TILE_ID_GROUND);
+
+	for (int i = 0; i < 6; i++) {
+		float side = (i & 1) ? 1.0f : -1.0f;
+		float vx = side * (0.5f + 1.0f * NextRngFloat(&particles->rng));
+		float vy = -0.5f - 1.0f * NextRngFloat(&particles->rng);
+		float u = source.x + NextRngRange(&particles->rng, TILESIZE - PARTICLE_SIZE);
+
+		EmitParticle(particles, feet.x - PARTICLE_SIZE / 2.0f, feet.y - PARTICLE_SIZE, vx, vy, 0.3f, u, source.y);
+	}
+}
+
+// Advances every particle by one tick. Particles don't collide, they just fall and fade,
+// so integration is a single vectorizable pass and retiring is a branch-free compaction
+void StepParticles(Game* game) {
+	Particles* particles = &game->particles;
+	int count = particles->count;
+
+	float* restrict x = particles->x;
+	float* restrict y = particles->y;
+	float* restrict vx = particles->vx;
+	float* restrict vy = particles->vy;
+	float* restrict life = particles->life;
+	float* restrict u = particles->u;
+	float* restrict v = particles->v;
+
+	for (int i = 0; i < count; i++) {
+		vy[i] += GRAVITY;
+		x[i] += vx[i];
+		y[i] += vy[i];
+		life[i] -= TICK_TIME;
+	}
+
+	// Retire dead particles by compacting the live ones down, every particle is copied
+	// and only the write cursor depends on whether it is still alive
+	int alive = 0;
+	for (int i = 0; i < count; i++) {
+		x[alive] = x[i];
+		y[alive] = y[i];
+		vx[alive] = vx[i];
+		vy[alive] = vy[i];
+		life[alive] = life[i];
+		u[alive] = u[i];
+		v[alive] = v[i];
+		alive += life[i] > 0.0f;
+	}
+	particles->count = alive;
+}
+
+// Draws every live particle as a textured quad in one rlgl batch, fading out over its last PARTICLE_FADE seconds
+void DrawParticles(Game* game) {
+	Particles* particles = &game->particles;
+	if (particles->count == 0) {
+		return;
+	}
+
+	const float texelW = 1.0f / txAtlas.width;
+	const float texelH = 1.0f / txAtlas.height;
+
+	rlSetTexture(txAtlas.id);
+	rlBegin(RL_QUADS);
+
+	for (int i = 0; i < particles->count; i++) {
+		float x0 = particles->x[i];
+		float y0 = particles->y[i];
+		float x1 = x0 + PARTICLE_SIZE;
+		float y1 = y0 + PARTICLE_SIZE;
+		float u0 = particles->u[i] * texelW;
+		float v0 = particles->v[i] * texelH;
+		float u1 = u0 + PARTICLE_SIZE * texelW;
+		float v1 = v0 + PARTICLE_SIZE * texelH;
+
+		float fade = particles->life[i] / PARTICLE_FADE;
+		unsigned char alpha = (unsigned char)(255.0f * (fade < 1.0f ? fade : 1.0f));
+
+		// PARTICLE_LIMIT quads don't fit one render batch, a full batch is drawn first and
+		// the quads mode and texture carry over, as in raylib's own shape drawing
+		rlCheckRenderBatchLimit(4);
+		rlColor4ub(255, 255, 255, alpha);
+
+		// same winding as raylib's DrawTexturePro
+		rlTexCoord2f(u0, v0);
+		rlVertex2f(x0, y0);
+		rlTexCoord2f(u0, v1);
+		rlVertex2f(x0, y1);
+		rlTexCoord2f(u1, v1);
+		rlVertex2f(x1, y1);
+		rlTexCoord2f(u1, v0);
+		rlVertex2f(x1, y0);
+	}
+
+	rlEnd();
+	rlSetTexture(0);
+}
@@ -2,81 +2,136 @@
 #include "raymath.h"
 
 #include "platformer.h"
+#include "src/systems/profiler.h"
 #include "src/systems/sprites.h"
 
 //------------------------------------------------------
 
+// Simulation state only, never touches the window, input devices or GL
+// so a game can run headless. Drawing needs LoadGameRenderer on top
 Game NewGame(int width, int height, int objectLimit) {
 	Game game = {0};
 	game.level = 0;
 	game.theme = THEME_GRASS;
 	game.score = 0;
 
-	game.player = NewPlayer((Vector2){0.0f, 0.0f}, (Vector2){15.0f, 31.0f});
+	// Everything the game owns comes out of its two arenas, nothing is freed one by one
+	game.arena = NewArena(GAME_ARENA_BLOCK);
+	game.levelArena = NewArena(LEVEL_ARENA_BLOCK);
+
+	game.player = NewPlayer(&game.arena, (Vector2){0.0f, 0.0f}, (Vector2){15.0f, 31.0f});
 
 	game.width = width;
 	game.height = height;
-	game.tilemap = MemAlloc(sizeof(Tile) * game.width * game.height);
-	for (int i = 0; i < game.width * game.height; i++) {
-		game.tilemap[i] = (Tile){0};
-	}
+	game.originX = 0;
+	game.wrapMask = ~0;
+	game.solidStride = (game.width + 31) / 32;
 
+	// Generations outlive levels so handles into an old level stay detectable
 	game.objectLimit = objectLimit;
-	game.objectCount = 0;
-	game.objects = MemAlloc(sizeof(Object) * game.objectLimit);
-	for (int i = 0; i < game.objectLimit; i++) {
-		game.objects[i] = (Object){0};
-	}
+	game.objectGenerations = ArenaAlloc(&game.arena, sizeof(unsigned int) * objectLimit);
+	LoadLevelBuffers(&game, true);
+
+	game.tileEditLimit = TILE_EDIT_LIMIT;
+	game.tileEdits = ArenaAlloc(&game.arena, sizeof(TileEdit) * TILE_EDIT_LIMIT);
+
+	LoadBodies(&game, BODY_LIMIT);
+	LoadParticles(&game, PARTICLE_LIMIT);
 
 	// Initialize global game vars
 	game.camera.target = (Vector2){
 		game.player->frame.x + game.player->frame.width / 2.0f,
 		game.player->frame.y + game.player->frame.height / 2.0f,
 	};
-	game.camera.offset = (Vector2){GetScreenWidth() / 2.0f, GetScreenHeight() / 2.0f};
+	game.camera.offset = (Vector2){VIEW_WIDTH / 2.0f, VIEW_HEIGHT / 2.0f};
 	game.camera.zoom = 1.0f;
 	game.camera.rotation = 0.0f;
+	game.prevCameraTarget = game.camera.target;
 
 	return game;
 }
 
-void DestroyGame(Game* game) {
-	game->level = 0;
-	game->theme = THEME_GRASS;
-	game->score = 0;
+// Endless runner game, the tilemap becomes a ring of chunk columns streamed ahead of the camera.
+// The storage width is rounded up to a power of two so world columns wrap with a mask
+Game NewEndlessGame(int width, int height, int objectLimit) {
+	int storageWidth = CHUNKSIZE * 2;
+	while (storageWidth < width) {
+		storageWidth <<= 1;
+	}
 
-	*game->player = (Player){0};
-	DestroyAnimation(&game->player->anim);
-	DestroyPlayer(&game->player);
+	Game game = NewGame(storageWidth, height, objectLimit);
+	game.endless = true;
+	game.wrapMask = storageWidth - 1;
 
-	game->camera = (Camera2D){0};
+	return game;
+}
+
+// Frees everything the game owns in one go, the renderer must be unloaded first
+void DestroyGame(Game* game) {
+	TraceLog(LOG_INFO, "ARENA: Game arena peak %zu bytes in %d blocks, level arena peak %zu bytes", game->arena.peak, game->arena.blockCount,
+			 game->levelArena.peak);
+
+	UnloadLevelFile(game);
+	DestroyArena(&game->levelArena);
+	DestroyArena(&game->arena);
+	*game = (Game){0};
+}
 
-	game->width = 0;
-	game->height = 0;
-	MemFree(game->tilemap);
-	game->tilemap = ((void*)0);
+// GPU tile mesh and the next level worker, only needed when the game is drawn
+void LoadGameRenderer(Game* game) {
+	LoadTileMesh(game);
+	LoadLevelPrefetch(game);
+}
 
-	game->objectLimit = 0;
-	MemFree(game->objects);
-	game->objects = ((void*)0);
+void UnloadGameRenderer(Game* game) {
+	UnloadLevelPrefetch(game); // waits for a running worker before its buffers go away
+	UnloadTileMesh(game);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void UpdateDrawGame(Game* game) {
-	// Update
-	//--------------------------------------------------------
-	if (IsKeyPressed(KEY_W)) {
+// Samples the keyboard once per frame into the pending tick input
+void PollGameInput(Game* game) {
+	game->pendingInput.left = IsKeyDown(KEY_A);
+	game->pendingInput.right = IsKeyDown(KEY_D);
+	game->pendingInput.jumpPressed |= IsKeyPressed(KEY_SPACE);
+	game->pendingInput.doorPressed |= IsKeyPressed(KEY_W);
+
+	// Replays only hold input, a rewound tick can't be played back
+	game->rewinding = game->rewind != ((void*)0) && game->replay == ((void*)0) && IsKeyDown(KEY_R);
+}
+
+// One fixed simulation step, the whole game update. Depends on nothing but
+// the game and input, no window, GL or global state, so it can run headless.
+// Profiler markers compile out unless the profiler is enabled
+void StepGame(Game* game, InputFrame input) {
+	game->input = input;
+	game->player->prevPosition = (Vector2){game->player->frame.x, game->player->frame.y};
+	game->prevCameraTarget = game->camera.target;
+
+	if (game->input.doorPressed) {
 		Object* obj = GetObjectAt(game, game->player->frame);
 		if (obj->id == OBJECT_ID_DOOR) {
 			NewLevel(game);
 		}
 	}
 
+	PROFILE_BEGIN("player");
 	UpdateGamePlayer(game);
+	PROFILE_END("player");
+
+	PROFILE_BEGIN("bodies");
+	StepBodies(game);
+	PROFILE_END("bodies");
+
+	PROFILE_BEGIN("particles");
+	StepParticles(game);
+	PROFILE_END("particles");
 
 	/* Update game->camera */
 
+	PROFILE_BEGIN("camera");
+
 	Vector2 camTargetPos = (Vector2){
 		game->player->frame.x + game->player->frame.width,
 		game->player->frame.y,
@@ -84,26 +139,121 @@ void UpdateDrawGame(Game* game) {
 
 	game->camera.target = Vector2Lerp(game->camera.target, camTargetPos, 0.15f);
 
-	// Draw
+	StreamEndlessWorld(game);
+	PROFILE_END("camera");
+}
+
+void UpdateDrawGame(Game* game) {
+	// Update
 	//--------------------------------------------------------
+	PROFILE_BEGIN("input");
+	PollGameInput(game);
+	PROFILE_END("input");
+
+#ifdef ENABLE_PROFILER
+	if (IsKeyPressed(KEY_F3)) {
+		game->showProfiler = !game->showProfiler;
+	}
+	if (IsKeyPressed(KEY_F4)) {
+		ExportProfilerCsv("profile.csv");
+	}
+	if (IsKeyPressed(KEY_F5)) {
+		ExportProfilerTrace("profile.json");
+	}
+#endif
+
+	float frameTime = GetFrameTime();
+	if (frameTime > MAX_FRAME_TIME) {
+		frameTime = MAX_FRAME_TIME;
+	}
+
+	game->accumulator += frameTime;
+	while (game->accumulator >= TICK_TIME) {
+		if (game->rewinding) {
+			RewindGameTick(game); // runs backwards at the tick rate, stops when history runs out
+		} else if (game->replay != ((void*)0)) {
+			InputFrame input = GetReplayInput(game->replay, game->pendingInput);
+			StepGame(game, input);
+			UpdateReplay(game->replay, game, input);
+		} else {
+			StepGame(game, game->pendingInput);
+			RecordRewindTick(game);
+		}
+		game->accumulator -= TICK_TIME;
+
+		// presses are consumed by the first tick, held keys carry on
+		game->pendingInput.jumpPressed = false;
+		game->pendingInput.doorPressed = false;
+	}
+
+	// Keep the next level generating in the background so entering the door is a swap
+	StartLevelPrefetch(game);
+
+	// How far the display is between the last two ticks
+	DrawGame(game, game->accumulator / TICK_TIME);
+
+	PROFILE_FRAME();
+}
+
+// Render pass, only reads the simulation apart from GPU and animation state
+void DrawGame(Game* game, float alpha) {
+	// Upload tile columns changed since the last frame
+	PROFILE_BEGIN("upload");
+	UpdateTileMesh(game);
+	PROFILE_END("upload");
+
+	UpdatePlayerAnimation(game);
+
+	Camera2D renderCamera = game->camera;
+	renderCamera.target = Vector2Lerp(game->prevCameraTarget, game->camera.target, alpha);
+	renderCamera.offset = (Vector2){GetScreenWidth() / 2.0f, GetScreenHeight() / 2.0f};
+
 	BeginDrawing();
 	ClearBackground(SKYBLUE);
 
-	BeginMode2D(game->camera);
+	BeginMode2D(renderCamera);
 
 	// Draw Tiles //
+	PROFILE_BEGIN("tilemap");
 	DrawGameTilemap(game);
-	DrawGameObjects(game);
+	PROFILE_END("tilemap");
+
+	PROFILE_BEGIN("objects");
+	DrawGameObjects(game, renderCamera);
+	PROFILE_END("objects");
+
+	PROFILE_BEGIN("sprites");
+	DrawParticles(game);
 
 	// Draw Player //
-	Vector2 pPos = {game->player->frame.x, game->player->frame.y};
-	DrawTextureRec(txPlayer, game->player->anim->rect, pPos, WHITE);
+	Vector2 pPos = Vector2Lerp(game->player->prevPosition, (Vector2){game->player->frame.x, game->player->frame.y}, alpha);
+	DrawTextureRec(txAtlas, game->player->anim->rect, pPos, WHITE);
 	EndMode2D();
+	PROFILE_END("sprites");
 
 	// Draw GUI not bound to game->camera
 	//-----------------------------
+	PROFILE_BEGIN("hud");
 	DrawText(TextFormat("Score: %d\nLevel: %d", game->score, game->level), 10, 10, 20, RAYWHITE);
+	if (game->replay != ((void*)0) && game->replay->mode == REPLAY_PLAYBACK) {
+		Color color = game->replay->firstMismatch < 0 ? RAYWHITE : RED;
+		DrawText(TextFormat("Replay %d/%d", game->replay->cursor, game->replay->tickCount), 10, 60, 20, color);
+	} else if (game->replay != ((void*)0) && game->replay->mode == REPLAY_RECORD) {
+		DrawText("Rec", 10, 60, 20, RED);
+	} else if (game->rewinding) {
+		DrawText(TextFormat("<< %.1fs", GetRewindTicks(game) * TICK_TIME), 10, 60, 20, RAYWHITE);
+	}
 	DrawFPS(GetScreenWidth() - 96, 16);
 
+#ifdef ENABLE_PROFILER
+	if (game->showProfiler) {
+		DrawProfilerOverlay(10, 90);
+	}
+#endif
+	PROFILE_END("hud");
+
+	// Buffer swap, includes waiting for vsync
+	PROFILE_BEGIN("present");
 	EndDrawing();
+	PROFILE_END("present");
 }
\ No newline at end of file
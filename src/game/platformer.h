@@ -2,14 +2,50 @@
 #define PLATFORMER_H
 
 #include "raylib.h"
+#include "src/systems/arena.h"
+#include "src/systems/rng.h"
 #include "src/systems/sprites.h"
 
+#include <stdint.h>
+
 #define TILESIZE 16
+#define CHUNKSIZE 16 // columns per streamed chunk in endless mode
+
+#define GAME_ARENA_BLOCK (2 * 1024 * 1024) // the default limits fit in one block
+#define LEVEL_ARENA_BLOCK (64 * 1024)		// grows to the level size on the first reset
+
+// Largest game a level file or replay may create, every per-tile buffer stays far below
+// MemAlloc's 4 GB. Drawn games are capped further by TILE_MESH_MAX_TILES
+#define LEVEL_MAX_SIDE 16384
+#define LEVEL_MAX_TILES (1 << 24)
+#define LEVEL_MAX_OBJECTS 65536
+
+// Storage index of world tile (x, y), columns wrap around the ring in endless mode
+#define TILE_INDEX(game, x, y) ((y) * (game)->width + ((x) & (game)->wrapMask))
 #define GRAVITY 0.3f
 
-extern Texture txTiles;
-extern Texture txPlayer;
-extern Texture txObjects;
+// Simulation runs at a fixed rate independent of the display, physics constants are per tick
+#define TICK_RATE 60
+#define TICK_TIME (1.0f / TICK_RATE)
+#define VIEW_WIDTH 640	// simulated view size, the area around the camera kept streamed
+#define VIEW_HEIGHT 360
+#define MAX_FRAME_TIME 0.25f // frame time cap so a long stall doesn't spiral into catch-up ticks
+
+// Every sprite sheet lives in one atlas texture so a frame draws in a single batch
+typedef enum AtlasRegion {
+	ATLAS_REGION_TILES,
+	ATLAS_REGION_PLAYER,
+	ATLAS_REGION_OBJECTS,
+	ATLAS_REGION_COUNT,
+} AtlasRegion;
+
+#define ATLAS_PADDING 1
+#define COOKED_ATLAS "assets/cooked/atlas.bin" // written by make cook, see src/tools/cook.c
+#define COOKED_MANIFEST "assets/cooked/manifest.txt" // the sources each cooked file came from
+
+extern Texture txAtlas;
+extern Rectangle atlasRegions[ATLAS_REGION_COUNT];
+extern const char* atlasSheets[ATLAS_REGION_COUNT];
 
 void LoadAssetsGame();
 void UnloadAssetsGame();
@@ -30,7 +66,7 @@ typedef enum ObjectId {
 /*----------------------------*/
 
 typedef struct Tile {
-	int id;
+	uint8_t id;
 } Tile;
 
 typedef struct Object {
@@ -38,6 +74,77 @@ typedef struct Object {
 	int x, y, w, h;
 } Object;
 
+// Stable reference to a pooled object, the generation detects that its slot was freed or reused
+typedef struct ObjectHandle {
+	int index;
+	unsigned int generation;
+} ObjectHandle;
+
+#define OBJECT_HANDLE_NONE ((ObjectHandle){-1, 0})
+
+#define OBJECT_CELL_SIZE (4 * TILESIZE)
+
+// Spatial hash of objects by the OBJECT_CELL_SIZE cells they overlap,
+// queries only visit objects near the queried area
+typedef struct ObjectGrid {
+	int bucketMask;
+	int* buckets;				// first entry per bucket, -1 when empty
+	unsigned int* bucketStamps; // clearStamp when the bucket was last valid
+	unsigned int clearStamp;
+
+	int entryLimit;
+	int entryCount; // high-water mark, entries below it are in use or on the free list
+	int* entryObject;		 // object index
+	unsigned int* entryCell; // full cell hash, to skip other cells sharing the bucket
+	int* entryNext;			 // next entry in the bucket, or in the free list
+	int freeEntry;
+
+	unsigned int* marks; // per object, stamp of the last query that visited it
+	unsigned int queryStamp;
+} ObjectGrid;
+
+// Rows top..bottom-1 of a storage column waiting for upload, clean when top >= bottom
+typedef struct TileRows {
+	int top, bottom;
+} TileRows;
+
+// Every resident cell, empty ones included, as a quad of one static mesh with resolved positions
+// and atlas UVs, drawn with a single call. Only the quads a tile change touches are re-uploaded.
+// At 120 bytes per cell (twice over with the prefetched level) drawn games are capped in size
+#define TILE_MESH_MAX_TILES (1 << 19) // 4096x128, about 60 MB of vertices
+
+typedef struct TileMesh {
+	Mesh mesh;
+	Material material;
+	TileRows* dirtyRows; // per storage column
+	bool uploadAll;		 // CPU arrays are current but the whole GPU buffer is stale
+} TileMesh;
+
+// A tile changed during play, per level log
+typedef struct TileEdit {
+	int x, y; // world tile
+	uint8_t before;
+	uint8_t after;
+} TileEdit;
+
+#define TILE_EDIT_LIMIT 4096
+
+// Game state at one tick, stored as a delta against the level's generated (or loaded) base:
+// the tile edit log instead of the tilemap, see snapshot.c
+typedef struct GameSnapshot {
+	int size;
+	int capacity;
+	unsigned char* data;
+} GameSnapshot;
+
+// Recent ticks kept for rewinding in a fixed-size ring, see rewind.c
+typedef struct Rewind Rewind;
+
+#define REWIND_BUFFER_SIZE (64 * 1024)
+
+// Next level generated ahead of time on a worker thread, see prefetch.c
+typedef struct LevelPrefetch LevelPrefetch;
+
 //--------------------------------------------------------
 
 typedef struct MovementInfo {
@@ -47,21 +154,110 @@ typedef struct MovementInfo {
 	float jumpPower;
 } MovementInfo;
 
+typedef struct Game Game;
+
+// Result of sweeping a box through the tilemap
+typedef struct TileHit {
+	float time;		// fraction of the motion travelled before contact, 1 if nothing was hit
+	Vector2 normal; // contact normal, zero if nothing was hit
+	int tileX, tileY;
+	bool hit;
+} TileHit;
+
+// Input for one simulation tick. Held keys are sampled each frame, presses are latched
+// until a tick consumes them so none get lost when frames outpace ticks
+typedef struct InputFrame {
+	bool left;
+	bool right;
+	bool jumpPressed;
+	bool doorPressed;
+} InputFrame;
+
+typedef enum ReplayMode {
+	REPLAY_NONE,
+	REPLAY_RECORD,
+	REPLAY_PLAYBACK,
+} ReplayMode;
+
+// Per-tick input of a session plus a state checksum per tick, replaying it
+// from the same seed must reproduce every checksum
+typedef struct Replay {
+	ReplayMode mode;
+	uint64_t seed; // seed of the first level, the rest are chained from it
+	int width, height, objectLimit;
+	bool endless;
+
+	int tickCount;
+	int tickCapacity;
+	uint8_t* inputs;	 // InputFrame bits per tick
+	uint32_t* checksums; // HashGameState after each tick
+
+	int cursor;		   // next tick to play back
+	int mismatches;	   // ticks whose checksum differed
+	int firstMismatch; // -1 while in sync
+} Replay;
+
 typedef struct Player {
 	Rectangle frame;
+	Vector2 prevPosition; // position at the start of the last tick, for render interpolation
 	Vector2 velocity;
 	MovementInfo movement;
 	Animation* anim;
+	float coyoteTimer;	   // seconds left to still jump after leaving the ground
+	float jumpBufferTimer; // seconds left to remember a jump press before landing
 	bool isGrounded;
 	bool isMoving;
 } Player;
 
-Player* NewPlayer(Vector2 startPos, Vector2 size);
-void DestroyPlayer(Player** player);
-void ResetPlayer(Player* player, Tile* tilemap, Vector2 bounds);
-void PlayerMoveAndCollideX(Player* player, Tile* tilemap, Vector2 bounds);
-int PlayerMoveAndCollideY(Player* player, Tile* tilemap, Vector2 bounds); // returns 1 if player hits a block
+Player* NewPlayer(Arena* arena, Vector2 startPos, Vector2 size);
+void ResetPlayer(Player* player, Game* game);
+void PlayerMoveAndCollideX(Player* player, Game* game);
+int PlayerMoveAndCollideY(Player* player, Game* game); // returns 1 if player hits a block
+
+
+//--------------------------------------------------------
+
+#define BODY_LIMIT 4096
+#define BODY_MAX_FALL 10.0f
+
+typedef enum BodyFlags {
+	BODY_GRAVITY = 1 << 0,	// falls with GRAVITY
+	BODY_BOUNCE = 1 << 1,	// reverses horizontally when it hits a wall
+	BODY_GROUNDED = 1 << 2, // set by StepBodies while standing on a tile
+} BodyFlags;
 
+// Enemies, pickups and other moving entities, stored as parallel arrays
+// so the integration pass runs over contiguous memory for every body at once
+typedef struct Bodies {
+	int capacity;
+	int count;
+	float* x;
+	float* y;
+	float* vx;
+	float* vy;
+	float* w;
+	float* h;
+	uint8_t* flags;
+} Bodies;
+
+#define PARTICLE_LIMIT 32768
+#define PARTICLE_SIZE 4		// square fragment size in pixels
+#define PARTICLE_FADE 0.25f // seconds of life left when a particle starts fading out
+
+// Purely visual debris, preallocated parallel arrays like the bodies.
+// Emitting and retiring never allocates, a full pool drops new particles
+typedef struct Particles {
+	int capacity;
+	int count;
+	float* x;
+	float* y;
+	float* vx;
+	float* vy;
+	float* life; // seconds left
+	float* u;	 // atlas pixel of the fragment
+	float* v;
+	Rng rng; // spread only, kept apart from the level generator
+} Particles;
 
 //--------------------------------------------------------
 typedef enum Theme {
@@ -69,35 +265,177 @@ typedef enum Theme {
 	THEME_SNOW,
 } Theme;
 
-typedef struct Game {
+struct Game {
 	Theme theme;
 	unsigned short score;
 	unsigned short level;
 
 	Camera2D camera;
+	Vector2 prevCameraTarget;
 	Player* player;
 
+	InputFrame input;		 // input of the tick being simulated
+	InputFrame pendingInput; // frontend only, sampled input waiting for the next tick
+	float accumulator; // frame time not yet simulated
+
+	Arena arena;	  // game lifetime, buffers sized by the map and the limits
+	Arena levelArena; // the current level's buffers, reset with every new level
+
+	uint64_t seed;	   // seed of the current level
+	bool seededLevels; // next level seeds derive from the current one instead of the clock
+	Rng rng;	   // only used by level generation
+
 	int width, height;
+	int originX;  // world column of the first resident column, 0 unless endless
+	int wrapMask; // world column -> storage column mask, ~0 unless endless
 	Tile* tilemap;
+	unsigned char* autotile; // cached GetTileDir result per tile, parallel to tilemap
+	uint32_t* solid;		 // 1 bit per tile, set for anything collidable
+	int solidStride;		 // words per bitset row
+	unsigned char* levelFile; // file the level's layers point into when loaded from one, see levelfile.c
+	size_t levelFileSize;
+
+	// Tiles changed since the level started, in order. Past the limit the log stops
+	// and snapshots fall back to storing the whole tilemap
+	TileEdit* tileEdits;
+	int tileEditCount;
+	int tileEditLimit;
+	bool tileEditsOverflowed;
+	uint64_t tileHash; // XOR of HashTile over every change since the level started, see RestoreTileAt
+
+	TileMesh tileMesh;
 
+	// Object pool, removed objects leave tombstones that the free list hands out again
 	int objectLimit;
-	int objectCount;
+	int objectCount; // slots in use or tombstoned
 	Object* objects;
-} Game;
+	unsigned int* objectGenerations; // per slot, bumped every time the slot is handed out
+	int* objectNextFree;
+	int objectFreeHead;
+	ObjectGrid objectGrid;
+
+	LevelPrefetch* prefetch;
+	Replay* replay;	   // optional, recorded or played back by UpdateDrawGame
+	bool showProfiler; // frontend only, F3 overlay when built with the profiler
+	Rewind* rewind;	   // optional, records every tick UpdateDrawGame steps
+	bool rewinding;	   // frontend only, the rewind key is held
+
+	Bodies bodies;
+	Particles particles;
+
+	// Endless runner mode, terrain is streamed in chunk columns ahead of the camera
+	bool endless;
+	int generatedX; // next world column to generate
+	float noiseZ;
+	int holeRun;
+};
 
 Game NewGame(int width, int height, int objectLimit);
+Game NewEndlessGame(int width, int height, int objectLimit);
 void DestroyGame(Game* game);
+void LoadGameRenderer(Game* game);
+void UnloadGameRenderer(Game* game);
+void StepGame(Game* game, InputFrame input);
+void DrawGame(Game* game, float alpha);
 void UpdateDrawGame(Game* game);
 void NewLevel(Game* game);
+void NewLevelWithSeed(Game* game, uint64_t seed);
+uint64_t NextLevelSeed(Game* game);
+void LoadLevelBuffers(Game* game, bool tileLayers);
+void GenerateLevel(Game* game, uint64_t seed);
+void StartGeneratedLevel(Game* game);
+bool IsLevelSizeValid(int width, int height);
+uint64_t HashGameLevel(Game* game);
+uint64_t HashTile(int x, int y, int id);
+void StreamEndlessWorld(Game* game);
+void StreamEndlessWorldTo(Game* game, int aheadX);
+
+void PollGameInput(Game* game);
 
 void UpdateGamePlayer(Game* game);
+void UpdatePlayerAnimation(Game* game);
 
-void AddGameObject(Game* game, Object object);
+void ClearGameObjects(Game* game);
+void RenewObjectGenerations(Game* game);
+ObjectHandle AddGameObject(Game* game, Object object);
+void RemoveGameObject(Game* game, ObjectHandle handle);
+Object* GetGameObject(Game* game, ObjectHandle handle);
+ObjectHandle GetObjectHandle(Game* game, Object* object);
 Object* GetObjectAt(Game* game, Rectangle hitbox);
+Object* GetObjectAtPoint(Game* game, Vector2 point);
+int QueryObjectsInRect(Game* game, Rectangle area, int* out, int maxOut);
+void RebuildObjectGrid(Game* game);
 
+void LoadObjectGrid(ObjectGrid* grid, Arena* arena, int objectLimit);
+void ClearObjectGrid(ObjectGrid* grid);
+
+bool IsTileInBounds(Game* game, int x, int y);
 Tile* GetTileAt(Game* game, int x, int y);
+void SetTileAt(Game* game, int x, int y, int id);
+void RestoreTileAt(Game* game, int x, int y, int id);
+void WriteTileAt(Game* game, int x, int y, int id);
+uint32_t GetSolidSpan(Game* game, int x0, int x1, int y);
+TileHit SweepTilemap(Game* game, Rectangle box, Vector2 motion);
+TileHit MoveBoxX(Game* game, Rectangle* box, float* velocity);
+TileHit MoveBoxY(Game* game, Rectangle* box, float* velocity);
 int GetTileDir(Game* game, int x, int y);
+void BuildAutotileCache(Game* game);
+void BuildSolidBits(Game* game);
+void UpdateAutotileAt(Game* game, int x, int y);
 void DrawGameTilemap(Game* game);
-void DrawGameObjects(Game* game);
+void DrawGameObjects(Game* game, Camera2D camera);
+
+void LoadBodies(Game* game, int capacity);
+int AddBody(Game* game, Rectangle frame, Vector2 velocity, uint8_t flags);
+void RemoveBody(Game* game, int index);
+void ClearBodies(Game* game);
+void StepBodies(Game* game);
+
+void LoadParticles(Game* game, int capacity);
+void ClearParticles(Game* game);
+void EmitTileDebris(Game* game, int x, int y, TileId id);
+void EmitLandingDust(Game* game, Vector2 feet);
+void StepParticles(Game* game);
+void DrawParticles(Game* game);
+
+bool IsTileMeshSizeValid(int width, int height);
+void LoadTileMesh(Game* game);
+void UnloadTileMesh(Game* game);
+void MarkTileColumnDirty(Game* game, int x);
+void MarkTileRowsDirty(Game* game, int x, int top, int bottom);
+void MarkAllTilesDirty(Game* game);
+void WriteAllTileQuads(Game* game);
+void UpdateTileMesh(Game* game);
+
+uint64_t HashGameState(Game* game);
+void StartReplayRecording(Replay* replay, Game* game);
+void UnloadReplay(Replay* replay);
+Game NewGameFromReplay(Replay* replay);
+bool IsReplayFinished(Replay* replay);
+InputFrame GetReplayInput(Replay* replay, InputFrame live);
+void UpdateReplay(Replay* replay, Game* game, InputFrame input);
+bool SaveReplay(Replay* replay, const char* fileName);
+bool LoadReplay(Replay* replay, const char* fileName);
+
+bool SaveLevelFile(Game* game, const char* fileName, bool compact);
+bool LoadLevelFile(Game* game, const char* fileName);
+bool GetLevelFileSize(const char* fileName, int* width, int* height);
+void UnloadLevelFile(Game* game);
+
+void LoadLevelPrefetch(Game* game);
+void UnloadLevelPrefetch(Game* game);
+void StartLevelPrefetch(Game* game);
+void CancelLevelPrefetch(Game* game);
+bool SwapPrefetchedLevel(Game* game);
+
+void SnapshotGame(Game* game, GameSnapshot* snapshot);
+bool RestoreGame(Game* game, const GameSnapshot* snapshot);
+void UnloadGameSnapshot(GameSnapshot* snapshot);
+
+void LoadRewind(Game* game, int bufferSize);
+void ClearRewind(Game* game);
+int GetRewindTicks(Game* game);
+void RecordRewindTick(Game* game);
+bool RewindGameTick(Game* game);
 
 #endif // PLATFORMER_H
\ No newline at end of file
@@ -6,8 +6,8 @@
 
 //------------------------------------------------------
 
-Player* NewPlayer(Vector2 startPos, Vector2 size) {
-	Player* player = MemAlloc(sizeof(Player));
+Player* NewPlayer(Arena* arena, Vector2 startPos, Vector2 size) {
+	Player* player = ArenaAlloc(arena, sizeof(Player));
 	player->frame = (Rectangle){
 		startPos.x,
 		startPos.y,
@@ -16,151 +16,53 @@ Player* NewPlayer(Vector2 startPos, Vector2 size) {
 	};
 
 	player->velocity = (Vector2){0.0f, 0.0f};
-	player->anim = NewAnimationFromSheet(txPlayer, 3, 4, 0.1f);
+	player->anim = ArenaAlloc(arena, sizeof(Animation));
+	InitAnimationFromSheet(player->anim, atlasRegions[ATLAS_REGION_PLAYER], 3, 4, 0.1f);
 	player->movement = (MovementInfo){3.0f, 1.0f, 0.85f, 6};
 
 	return player;
 }
 
-void DestroyPlayer(Player** player) {
-	MemFree(*player);
-	*player = ((void*)0);
-}
-
-void ResetPlayer(Player* player, Tile* tilemap, Vector2 bounds) {
+void ResetPlayer(Player* player, Game* game) {
 	player->frame.x = 3 * TILESIZE;
 
-	for (int y = 0; y < bounds.y; y++) {
-		int idx = y * bounds.x + 3;
-		if (tilemap[idx].id == TILE_ID_GROUND) {
+	// stand on the surface, collision never pushes the player out of the ground
+	for (int y = 0; y < game->height; y++) {
+		if (GetTileAt(game, 3, y)->id == TILE_ID_GROUND) {
 			player->frame.y = (y - 3) * TILESIZE;
+			player->prevPosition = (Vector2){player->frame.x, player->frame.y}; // no interpolation across a teleport
 			player->velocity = (Vector2){0, 0};
+			player->coyoteTimer = 0.0f;
+			player->jumpBufferTimer = 0.0f;
 			player->isGrounded = true;
+			break;
 		}
 	}
 }
 
-void PlayerMoveAndCollideX(Player* player, Tile* tilemap, Vector2 bounds) {
-	// Move horizontally
-	player->frame.x += player->velocity.x;
+void PlayerMoveAndCollideX(Player* player, Game* game) {
 	player->isMoving = player->velocity.x < -0.3f || player->velocity.x > 0.3f;
 
-	// Compute AABB tile coverage
-	int bodyTop = (int)(player->frame.y / TILESIZE);
-	int bodyBottom = (int)((player->frame.y + player->frame.height) / TILESIZE);
-	int bodyLeft = (int)(player->frame.x / TILESIZE);
-	int bodyRight = (int)((player->frame.x + player->frame.width) / TILESIZE);
-
-	// Clamp tile indices to world bounds
-	if (bodyTop < 0) {
-		bodyTop = 0;
-	}
-	if (bodyLeft < 0) {
-		bodyLeft = 0;
-	}
-	if (bodyBottom >= (int)bounds.y) {
-		bodyBottom = (int)bounds.y - 1;
-	}
-	if (bodyRight >= (int)bounds.x) {
-		bodyRight = (int)bounds.x - 1;
-	}
-
-	// Check for horizontal collisions
-	for (int y = bodyTop; y <= bodyBottom; y++) {
-		for (int x = bodyLeft; x <= bodyRight; x++) {
-			int idx = y * (int)bounds.x + x;
-			Tile tile = tilemap[idx];
-
-			if (tile.id == TILE_ID_NONE) {
-				continue; // Skip empty tiles
-			}
-
-			Rectangle tileRec = {
-				x * TILESIZE,
-				y * TILESIZE,
-				TILESIZE,
-				TILESIZE,
-			};
-
-			if (CheckCollisionRecs(player->frame, tileRec)) {
-				// Resolve collision depending on movement direction
-				if (player->velocity.x > 0) {
-					player->frame.x = tileRec.x - player->frame.width - 0.001f;
-				} else if (player->velocity.x < 0) {
-					player->frame.x = tileRec.x + tileRec.width + 0.001f;
-				}
-
-				// Stop horizontal velocity
-				player->velocity.x = 0;
-			}
-		}
-	}
+	// Sweep horizontally, stopping against the first wall in the way
+	MoveBoxX(game, &player->frame, &player->velocity.x);
 }
 
-int PlayerMoveAndCollideY(Player* player, Tile* tilemap, Vector2 bounds) {
+int PlayerMoveAndCollideY(Player* player, Game* game) {
 	int result = 0;
 
-	// Move vertically
-	player->frame.y += player->velocity.y;
-	player->isGrounded = false; // Reset each frame
-
-	// Compute AABB tile coverage
-	int bodyTop = (int)(player->frame.y / TILESIZE);
-	int bodyBottom = (int)((player->frame.y + player->frame.height) / TILESIZE);
-	int bodyLeft = (int)(player->frame.x / TILESIZE);
-	int bodyRight = (int)((player->frame.x + player->frame.width) / TILESIZE);
-
-	// Clamp to world bounds
-	if (bodyTop < 0) {
-		bodyTop = 0;
-	}
-	if (bodyLeft < 0) {
-		bodyLeft = 0;
-	}
-	if (bodyBottom >= (int)bounds.y) {
-		bodyBottom = (int)bounds.y - 1;
-	}
-	if (bodyRight >= (int)bounds.x) {
-		bodyRight = (int)bounds.x - 1;
-	}
-
-	// Check for vertical collisions
-	for (int y = bodyTop; y <= bodyBottom; y++) {
-		for (int x = bodyLeft; x <= bodyRight; x++) {
-			int idx = y * (int)bounds.x + x;
-			Tile tile = tilemap[idx];
-
-			if (tile.id == TILE_ID_NONE) {
-				continue; // Skip empty tiles
-			}
-
-			// Tile Rectangle
-			Rectangle tileRec = {
-				x * TILESIZE,
-				y * TILESIZE,
-				TILESIZE,
-				TILESIZE,
-			};
-
-			// Check for AABB overlap
-			if (CheckCollisionRecs(player->frame, tileRec)) {
-				if (player->velocity.y > 0) {
-					// Moving down hit the ground
-					player->frame.y = tileRec.y - player->frame.height; // Snap to top of tile
-					player->isGrounded = true;
-				} else if (player->velocity.y < 0) {
-					// Moving up hit ceiling
-					player->frame.y = tileRec.y + tileRec.height; // Snap below tile
-
-					// Break If tile above is a block
-					if (tilemap[idx].id == TILE_ID_BLOCK) {
-						tilemap[idx] = (Tile){0};
-						result = 1; // Signify that the player hit a block
-					}
-				}
-
-				// Stop vertical velocity
-				player->velocity.y = 0;
+	// Sweep vertically
+	TileHit hit = MoveBoxY(game, &player->frame, &player->velocity.y);
+	player->isGrounded = hit.hit && hit.normal.y < 0.0f;
+
+	if (hit.hit && hit.normal.y > 0.0f) {
+		// Moving up hit ceiling, break every block the head hit in that row
+		int first = (int)(player->frame.x / TILESIZE);
+		int last = (int)((player->frame.x + player->frame.width - 0.001f) / TILESIZE);
+		for (int x = first; x <= last; x++) {
+			if (GetTileAt(game, x, hit.tileY)->id == TILE_ID_BLOCK) {
+				SetTileAt(game, x, hit.tileY, TILE_ID_NONE);
+				EmitTileDebris(game, x, hit.tileY, TILE_ID_BLOCK);
+				result = 1; // Signify that the player hit a block
 			}
 		}
 	}
@@ -170,19 +72,18 @@ int PlayerMoveAndCollideY(Player* player, Tile* tilemap, Vector2 bounds) {
 
 //-----------------------------------------------------------------------------------------------------------------------------------
 
+// Advances the player by one fixed tick
 void UpdateGamePlayer(Game* game) {
 	// Timers for coyote time & jump buffering
-	float dt = GetFrameTime();
+	float dt = TICK_TIME;
 	const float COYOTE_TIME = 0.12f;	  // seconds player can still jump after leaving ground
 	const float JUMP_BUFFER_TIME = 0.12f; // seconds to remember a jump press before landing
-	static float coyoteTimer = 0.0f;
-	static float jumpBufferTimer = 0.0f;
 
 	/* Update Player Movement */
 
-	if (IsKeyDown(KEY_D)) {
+	if (game->input.right) {
 		game->player->velocity.x += game->player->movement.acceleration;
-	} else if (IsKeyDown(KEY_A)) {
+	} else if (game->input.left) {
 		game->player->velocity.x -= game->player->movement.acceleration;
 	}
 
@@ -190,52 +91,68 @@ void UpdateGamePlayer(Game* game) {
 	game->player->velocity.x = Clamp(game->player->velocity.x, -game->player->movement.maxSpeed, game->player->movement.maxSpeed);
 
 	// Record jump presses into the buffer
-	if (IsKeyPressed(KEY_SPACE)) {
-		jumpBufferTimer = JUMP_BUFFER_TIME;
+	if (game->input.jumpPressed) {
+		game->player->jumpBufferTimer = JUMP_BUFFER_TIME;
 	}
 
 	// Update coyote timer: reset when grounded, otherwise count down
 	if (game->player->isGrounded) {
-		coyoteTimer = COYOTE_TIME;
+		game->player->coyoteTimer = COYOTE_TIME;
 	} else {
-		coyoteTimer -= dt;
-		if (coyoteTimer < 0.0f) {
-			coyoteTimer = 0.0f;
+		game->player->coyoteTimer -= dt;
+		if (game->player->coyoteTimer < 0.0f) {
+			game->player->coyoteTimer = 0.0f;
 		}
 	}
 
 	// Count down jump buffer
-	if (jumpBufferTimer > 0.0f) {
-		jumpBufferTimer -= dt;
-		if (jumpBufferTimer < 0.0f) {
-			jumpBufferTimer = 0.0f;
+	if (game->player->jumpBufferTimer > 0.0f) {
+		game->player->jumpBufferTimer -= dt;
+		if (game->player->jumpBufferTimer < 0.0f) {
+			game->player->jumpBufferTimer = 0.0f;
 		}
 	}
 
 	// Perform jump if buffered and allowed by grounding or coyote time
-	if (jumpBufferTimer > 0.0f && (game->player->isGrounded || coyoteTimer > 0.0f)) {
+	if (game->player->jumpBufferTimer > 0.0f && (game->player->isGrounded || game->player->coyoteTimer > 0.0f)) {
 		game->player->velocity.y = -game->player->movement.jumpPower;
 		// consume both timers so double-triggering is avoided
-		jumpBufferTimer = 0.0f;
-		coyoteTimer = 0.0f;
+		game->player->jumpBufferTimer = 0.0f;
+		game->player->coyoteTimer = 0.0f;
 		game->player->isGrounded = false;
 	}
 
+	// Terminal velocity, sweeping means this no longer has to stay below a tile per tick
 	game->player->velocity.y += GRAVITY;
 	game->player->velocity.y = Clamp(game->player->velocity.y, -10, 10);
 
-	PlayerMoveAndCollideX(game->player, game->tilemap, (Vector2){game->width, game->height});
-	if (PlayerMoveAndCollideY(game->player, game->tilemap, (Vector2){game->width, game->height})) {
+	PlayerMoveAndCollideX(game->player, game);
+
+	bool wasGrounded = game->player->isGrounded;
+	float fallSpeed = game->player->velocity.y;
+	if (PlayerMoveAndCollideY(game->player, game)) {
 		game->score++;
 	}
 
+	// Dust only for real landings, not for every tick of walking
+	if (!wasGrounded && game->player->isGrounded && fallSpeed > 3.0f) {
+		Rectangle frame = game->player->frame;
+		EmitLandingDust(game, (Vector2){frame.x + frame.width / 2.0f, frame.y + frame.height});
+	}
+
 	// check if player fall
 
 	if (game->player->frame.y > game->height * TILESIZE) {
-		ResetPlayer(game->player, game->tilemap, (Vector2){game->width, game->height});
+		if (game->endless) {
+			NewLevel(game); // a fall ends the run, start over from a fresh world
+		} else {
+			ResetPlayer(game->player, game);
+		}
 	}
+}
 
-	/* Update Player Animation */
+// Picks and advances the player animation, once per rendered frame
+void UpdatePlayerAnimation(Game* game) {
 	if (game->player->isMoving) {
 		SetAnimation(game->player->anim, 1); // walk anim
 
@@ -0,0 +1,162 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+
+// Native builds always have pthreads, on the web only when built with -pthread
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define PREFETCH_THREADED
+#include <pthread.h>
+#endif
+
+#define SWAP(type, a, b) \
+	do {                 \
+		type tmp = (a);  \
+		(a) = (b);       \
+		(b) = tmp;       \
+	} while (0)
+
+// A shadow game with its own level buffers, the worker generates into it
+// while the real game keeps running. Entering the next level swaps buffers
+struct LevelPrefetch {
+	Game next;
+	bool pending; // a level was started and not swapped in yet
+#ifdef PREFETCH_THREADED
+	bool running; // the worker thread still has to be joined
+	pthread_t thread;
+#endif
+};
+
+//-----------------------------------------------------------------------------------------
+
+void LoadLevelPrefetch(Game* game) {
+	LevelPrefetch* prefetch = ArenaAlloc(&game->arena, sizeof(LevelPrefetch));
+	Game* next = &prefetch->next;
+
+	// Only the level buffers are owned by the shadow, nothing else is ever touched there.
+	// They are carved from its own level arena when the worker generates, and swap
+	// sides together with that arena
+	next->levelArena = NewArena(LEVEL_ARENA_BLOCK);
+	next->objectLimit = game->objectLimit;
+	next->objectGenerations = ArenaAlloc(&game->arena, sizeof(unsigned int) * game->objectLimit);
+
+	// Freed by UnloadMesh once swapped into the game, so these stay on the heap
+	next->tileMesh.mesh.vertices = MemAlloc(sizeof(float) * 3 * game->tileMesh.mesh.vertexCount);
+	next->tileMesh.mesh.texcoords = MemAlloc(sizeof(float) * 2 * game->tileMesh.mesh.vertexCount);
+
+	prefetch->pending = false;
+	game->prefetch = prefetch;
+}
+
+static void WaitLevelPrefetch(LevelPrefetch* prefetch) {
+#ifdef PREFETCH_THREADED
+	if (prefetch->running) {
+		pthread_join(prefetch->thread, ((void*)0));
+		prefetch->running = false;
+	}
+#endif
+}
+
+void UnloadLevelPrefetch(Game* game) {
+	LevelPrefetch* prefetch = game->prefetch;
+	Game* next = &prefetch->next;
+
+	WaitLevelPrefetch(prefetch);
+
+	UnloadLevelFile(next);
+	DestroyArena(&next->levelArena);
+	MemFree(next->tileMesh.mesh.vertices);
+	MemFree(next->tileMesh.mesh.texcoords);
+
+	game->prefetch = ((void*)0); // the prefetch itself is game arena memory
+}
+
+static void* RunLevelPrefetch(void* arg) {
+	Game* next = arg;
+
+	GenerateLevel(next, next->seed);
+	WriteAllTileQuads(next);
+
+	return ((void*)0);
+}
+
+// Starts generating the next level in the background, does nothing if one is already pending.
+// Without thread support it generates right away, still off the door-entering frame
+void StartLevelPrefetch(Game* game) {
+	LevelPrefetch* prefetch = game->prefetch;
+	Game* next = &prefetch->next;
+
+	if (prefetch->pending) {
+		return;
+	}
+
+	// Copy the map layout, buffers stay the shadow's own
+	next->width = game->width;
+	next->height = game->height;
+	next->wrapMask = game->wrapMask;
+	next->solidStride = game->solidStride;
+	next->endless = game->endless;
+	next->tileMesh.mesh.vertexCount = game->tileMesh.mesh.vertexCount;
+	next->seed = NextLevelSeed(game);
+
+	prefetch->pending = true;
+
+#ifdef PREFETCH_THREADED
+	prefetch->running = pthread_create(&prefetch->thread, ((void*)0), RunLevelPrefetch, next) == 0;
+	if (!prefetch->running) {
+		TraceLog(LOG_WARNING, "PREFETCH: Failed to start worker, generating on the main thread");
+		RunLevelPrefetch(next);
+	}
+#else
+	RunLevelPrefetch(next);
+#endif
+}
+
+// Drops a pending level, for when the current one was replaced by other means
+// and the next seed derives from a different level now
+void CancelLevelPrefetch(Game* game) {
+	LevelPrefetch* prefetch = game->prefetch;
+	if (prefetch == ((void*)0)) {
+		return;
+	}
+
+	WaitLevelPrefetch(prefetch);
+	prefetch->pending = false;
+}
+
+// Swaps the pre-generated level in, returns false if none was started.
+// Only exchanges pointers plus one GPU upload, if the worker is still running it waits for it
+bool SwapPrefetchedLevel(Game* game) {
+	LevelPrefetch* prefetch = game->prefetch;
+	if (prefetch == ((void*)0) || !prefetch->pending) {
+		return false; // headless games have no prefetch
+	}
+	Game* next = &prefetch->next;
+
+	WaitLevelPrefetch(prefetch);
+	prefetch->pending = false;
+
+	SWAP(Tile*, game->tilemap, next->tilemap);
+	SWAP(unsigned char*, game->autotile, next->autotile);
+	SWAP(uint32_t*, game->solid, next->solid);
+	SWAP(Object*, game->objects, next->objects);
+	SWAP(int, game->objectCount, next->objectCount);
+	SWAP(int*, game->objectNextFree, next->objectNextFree);
+	SWAP(int, game->objectFreeHead, next->objectFreeHead);
+	SWAP(ObjectGrid, game->objectGrid, next->objectGrid);
+	SWAP(Arena, game->levelArena, next->levelArena);
+	SWAP(unsigned char*, game->levelFile, next->levelFile); // released when the shadow generates again
+	SWAP(size_t, game->levelFileSize, next->levelFileSize);
+	SWAP(float*, game->tileMesh.mesh.vertices, next->tileMesh.mesh.vertices);
+	SWAP(float*, game->tileMesh.mesh.texcoords, next->tileMesh.mesh.texcoords);
+
+	game->seed = next->seed;
+	game->rng = next->rng;
+	game->noiseZ = next->noiseZ;
+	game->holeRun = next->holeRun;
+	game->originX = next->originX;
+	game->generatedX = next->generatedX;
+	game->tileMesh.uploadAll = true;
+	RenewObjectGenerations(game); // generations stay with the game, the shadow's are its own
+
+	StartGeneratedLevel(game);
+	return true;
+}
@@ -0,0 +1,262 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+
+#include <string.h>
+
+// File layout: ReplayHeader, then one input byte per tick, then one checksum per tick.
+// Fields are stored in host order, every target we build for is little-endian
+#define REPLAY_MAGIC "JDRP"
+#define REPLAY_VERSION 1
+
+typedef struct ReplayHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t seed;
+	int32_t width;
+	int32_t height;
+	int32_t objectLimit;
+	uint32_t endless;
+	uint32_t tickCount;
+	uint32_t reserved;
+} ReplayHeader;
+
+typedef enum InputBits {
+	INPUT_LEFT = 1 << 0,
+	INPUT_RIGHT = 1 << 1,
+	INPUT_JUMP = 1 << 2,
+	INPUT_DOOR = 1 << 3,
+} InputBits;
+
+//-----------------------------------------------------------------------------------------
+
+static uint8_t PackInputFrame(InputFrame input) {
+	return (input.left ? INPUT_LEFT : 0) | (input.right ? INPUT_RIGHT : 0) | (input.jumpPressed ? INPUT_JUMP : 0) |
+		   (input.doorPressed ? INPUT_DOOR : 0);
+}
+
+static InputFrame UnpackInputFrame(uint8_t bits) {
+	return (InputFrame){
+		.left = (bits & INPUT_LEFT) != 0,
+		.right = (bits & INPUT_RIGHT) != 0,
+		.jumpPressed = (bits & INPUT_JUMP) != 0,
+		.doorPressed = (bits & INPUT_DOOR) != 0,
+	};
+}
+
+// Scalar state HashGameState covers, gathered so it hashes in one pass
+typedef struct HashedState {
+	uint64_t tileHash;
+	uint64_t seed;
+	Rng rng; // endless streaming draws from it
+	Rectangle frame;
+	Vector2 velocity;
+	float coyoteTimer;
+	float jumpBufferTimer;
+	Vector2 cameraTarget;
+	int32_t originX;
+	int32_t generatedX;
+	int32_t bodyCount;
+	uint16_t score;
+	uint16_t level;
+	uint32_t isGrounded;
+} HashedState;
+
+// Hash of everything the simulation carries from one tick to the next, particles
+// and animation are cosmetic and left out. The level follows from the seed and the
+// generator state, tiles only count through the changes made since, so a tick costs
+// O(objects + bodies) rather than O(map)
+uint64_t HashGameState(Game* game) {
+	Player* player = game->player;
+	HashedState state;
+	memset(&state, 0, sizeof(state)); // padding included
+	state.tileHash = game->tileHash;
+	state.seed = game->seed;
+	state.rng = game->rng;
+	state.frame = player->frame;
+	state.velocity = player->velocity;
+	state.coyoteTimer = player->coyoteTimer;
+	state.jumpBufferTimer = player->jumpBufferTimer;
+	state.cameraTarget = game->camera.target;
+	state.originX = game->originX;
+	state.generatedX = game->generatedX;
+	state.bodyCount = game->bodies.count;
+	state.score = game->score;
+	state.level = game->level;
+	state.isGrounded = player->isGrounded;
+
+	uint64_t hash = HashBytes(&state, sizeof(state), 0);
+	hash = HashBytes(game->objects, sizeof(Object) * game->objectCount, hash);
+
+	Bodies* bodies = &game->bodies;
+	if (bodies->count > 0) {
+		hash = HashBytes(bodies->x, sizeof(float) * bodies->count, hash);
+		hash = HashBytes(bodies->y, sizeof(float) * bodies->count, hash);
+		hash = HashBytes(bodies->vx, sizeof(float) * bodies->count, hash);
+		hash = HashBytes(bodies->vy, sizeof(float) * bodies->count, hash);
+	}
+
+	return hash;
+}
+
+//-----------------------------------------------------------------------------------------
+
+// Starts recording from the start of the game's current level. Later level seeds are
+// chained from it so the whole session can be regenerated from this one seed
+void StartReplayRecording(Replay* replay, Game* game) {
+	*replay = (Replay){0};
+	replay->mode = REPLAY_RECORD;
+	replay->seed = game->seed;
+	replay->width = game->width;
+	replay->height = game->height;
+	replay->objectLimit = game->objectLimit;
+	replay->endless = game->endless;
+	replay->firstMismatch = -1;
+
+	if (game->levelFile != ((void*)0)) {
+		TraceLog(LOG_WARNING, "REPLAY: Level was loaded from a file, playback regenerates it from its seed instead");
+	}
+	game->seededLevels = true;
+}
+
+void UnloadReplay(Replay* replay) {
+	MemFree(replay->inputs);
+	MemFree(replay->checksums);
+	*replay = (Replay){0};
+}
+
+// Creates the game a replay was recorded on, at the start of its first level
+Game NewGameFromReplay(Replay* replay) {
+	Game game = replay->endless ? NewEndlessGame(replay->width, replay->height, replay->objectLimit)
+								: NewGame(replay->width, replay->height, replay->objectLimit);
+	game.seededLevels = true;
+	NewLevelWithSeed(&game, replay->seed);
+
+	replay->mode = REPLAY_PLAYBACK;
+	replay->cursor = 0;
+	replay->mismatches = 0;
+	replay->firstMismatch = -1;
+
+	return game;
+}
+
+bool IsReplayFinished(Replay* replay) {
+	return replay->mode == REPLAY_PLAYBACK && replay->cursor >= replay->tickCount;
+}
+
+// Input for the next tick, the recorded one during playback, otherwise live
+InputFrame GetReplayInput(Replay* replay, InputFrame live) {
+	if (replay->mode != REPLAY_PLAYBACK || replay->cursor >= replay->tickCount) {
+		return live;
+	}
+
+	return UnpackInputFrame(replay->inputs[replay->cursor]);
+}
+
+// Call after every StepGame. Recording appends the tick, playback checks the game
+// still hashes the same as when it was recorded
+void UpdateReplay(Replay* replay, Game* game, InputFrame input) {
+	uint32_t checksum = (uint32_t)HashGameState(game);
+
+	if (replay->mode == REPLAY_RECORD) {
+		if (replay->tickCount >= replay->tickCapacity) {
+			replay->tickCapacity = replay->tickCapacity ? replay->tickCapacity * 2 : 4096;
+			replay->inputs = MemRealloc(replay->inputs, sizeof(uint8_t) * replay->tickCapacity);
+			replay->checksums = MemRealloc(replay->checksums, sizeof(uint32_t) * replay->tickCapacity);
+		}
+
+		replay->inputs[replay->tickCount] = PackInputFrame(input);
+		replay->checksums[replay->tickCount] = checksum;
+		replay->tickCount++;
+	} else if (replay->mode == REPLAY_PLAYBACK && replay->cursor < replay->tickCount) {
+		if (replay->checksums[replay->cursor] != checksum) {
+			if (replay->firstMismatch < 0) {
+				replay->firstMismatch = replay->cursor;
+				TraceLog(LOG_WARNING, "REPLAY: Desync at tick %d", replay->cursor);
+			}
+			replay->mismatches++;
+		}
+		replay->cursor++;
+	}
+}
+
+//-----------------------------------------------------------------------------------------
+
+bool SaveReplay(Replay* replay, const char* fileName) {
+	ReplayHeader header = {
+		.magic = REPLAY_MAGIC,
+		.version = REPLAY_VERSION,
+		.seed = replay->seed,
+		.width = replay->width,
+		.height = replay->height,
+		.objectLimit = replay->objectLimit,
+		.endless = replay->endless,
+		.tickCount = replay->tickCount,
+	};
+
+	int size = sizeof(header) + replay->tickCount * (sizeof(uint8_t) + sizeof(uint32_t));
+	unsigned char* data = MemAlloc(size);
+	unsigned char* at = data;
+
+	memcpy(at, &header, sizeof(header));
+	at += sizeof(header);
+	memcpy(at, replay->inputs, sizeof(uint8_t) * replay->tickCount);
+	at += sizeof(uint8_t) * replay->tickCount;
+	memcpy(at, replay->checksums, sizeof(uint32_t) * replay->tickCount);
+
+	bool success = SaveFileData(fileName, data, size);
+	MemFree(data);
+
+	return success;
+}
+
+bool LoadReplay(Replay* replay, const char* fileName) {
+	*replay = (Replay){0};
+
+	int size = 0;
+	unsigned char* data = LoadFileData(fileName, &size);
+	if (data == ((void*)0)) {
+		return false;
+	}
+
+	ReplayHeader header;
+	if (size < (int)sizeof(header)) {
+		TraceLog(LOG_WARNING, "REPLAY: [%s] Too small to be a replay", fileName);
+		UnloadFileData(data);
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	// the tick count is bounded by the file size before it is multiplied
+	const int tickSize = sizeof(uint8_t) + sizeof(uint32_t);
+	uint32_t tickLimit = (size - sizeof(header)) / tickSize;
+	if (memcmp(header.magic, REPLAY_MAGIC, 4) != 0 || header.version != REPLAY_VERSION || header.tickCount > tickLimit ||
+		size != (int)sizeof(header) + (int)header.tickCount * tickSize) {
+		TraceLog(LOG_WARNING, "REPLAY: [%s] Not a version %d replay", fileName, REPLAY_VERSION);
+		UnloadFileData(data);
+		return false;
+	}
+
+	if (!IsLevelSizeValid(header.width, header.height) || header.objectLimit <= 0 || header.objectLimit > LEVEL_MAX_OBJECTS) {
+		TraceLog(LOG_WARNING, "REPLAY: [%s] Recorded on a %dx%d game with %d objects", fileName, header.width, header.height, header.objectLimit);
+		UnloadFileData(data);
+		return false;
+	}
+
+	replay->mode = REPLAY_PLAYBACK;
+	replay->seed = header.seed;
+	replay->width = header.width;
+	replay->height = header.height;
+	replay->objectLimit = header.objectLimit;
+	replay->endless = header.endless != 0;
+	replay->tickCount = header.tickCount;
+	replay->tickCapacity = header.tickCount;
+	replay->firstMismatch = -1;
+
+	replay->inputs = MemAlloc(sizeof(uint8_t) * replay->tickCount);
+	replay->checksums = MemAlloc(sizeof(uint32_t) * replay->tickCount);
+	memcpy(replay->inputs, data + sizeof(header), sizeof(uint8_t) * replay->tickCount);
+	memcpy(replay->checksums, data + sizeof(header) + replay->tickCount, sizeof(uint32_t) * replay->tickCount);
+
+	UnloadFileData(data);
+	return true;
+}
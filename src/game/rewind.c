@@ -0,0 +1,258 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+
+#include <string.h>
+
+// Every tick appends one record to a byte ring: the XOR of the rewound state against the
+// previous tick, changed words only with their leading zero bytes dropped, then the tile
+// edits the tick made. Rewinding pops the newest record and XORs it back in. A full ring
+// drops its oldest records, so memory stays at the size given to LoadRewind.
+//
+// Record: u16 length, u16 changed word mask, u32 byte counts (2 bits per changed word),
+// u8 edit count, the word bytes, 8 bytes per edit, u16 length again to walk backwards
+#define REWIND_EDIT_LIMIT 32 // per tick, more starts the history over
+#define REWIND_RECORD_MAX (11 + REWIND_WORDS * 4 + REWIND_EDIT_LIMIT * 8)
+
+// Everything a tick changes that rewinding restores, one word per field
+typedef struct RewindState {
+	Rectangle frame;
+	Vector2 prevPosition;
+	Vector2 velocity;
+	float coyoteTimer;
+	float jumpBufferTimer;
+	uint32_t flags; // isGrounded, isMoving
+	Vector2 cameraTarget;
+	Vector2 prevCameraTarget;
+	uint32_t score;
+} RewindState;
+
+#define REWIND_WORDS ((int)(sizeof(RewindState) / sizeof(uint32_t)))
+
+struct Rewind {
+	unsigned char* buffer;
+	unsigned int mask; // buffer size - 1, a power of two
+	unsigned int head; // end of the newest record, positions wrap through mask
+	unsigned int tail; // start of the oldest record
+	int tickCount;	   // ticks that can be undone
+
+	bool started;		  // last holds the state after the newest record
+	unsigned short level; // history never crosses a level change
+	int editCount;		  // game->tileEditCount after the newest record
+	uint32_t last[REWIND_WORDS];
+};
+
+//-----------------------------------------------------------------------------------------
+
+// Allocates bufferSize bytes (rounded down to a power of two) of history from the game arena.
+// A tick usually takes 20 to 40 bytes, 64 KB keeps well over 10 seconds
+void LoadRewind(Game* game, int bufferSize) {
+	unsigned int size = 1024;
+	while (size * 2 <= (unsigned int)bufferSize) {
+		size *= 2;
+	}
+
+	Rewind* rewind = ArenaAlloc(&game->arena, sizeof(Rewind));
+	rewind->buffer = ArenaAlloc(&game->arena, size);
+	rewind->mask = size - 1;
+	game->rewind = rewind;
+}
+
+// Forgets the history, recording starts over from the next tick
+void ClearRewind(Game* game) {
+	Rewind* rewind = game->rewind;
+	if (rewind == ((void*)0)) {
+		return;
+	}
+
+	rewind->head = rewind->tail = 0;
+	rewind->tickCount = 0;
+	rewind->started = false;
+}
+
+int GetRewindTicks(Game* game) {
+	return game->rewind != ((void*)0) ? game->rewind->tickCount : 0;
+}
+
+static void CaptureRewindState(Game* game, uint32_t* words) {
+	Player* player = game->player;
+	RewindState state = {
+		.frame = player->frame,
+		.prevPosition = player->prevPosition,
+		.velocity = player->velocity,
+		.coyoteTimer = player->coyoteTimer,
+		.jumpBufferTimer = player->jumpBufferTimer,
+		.flags = player->isGrounded | player->isMoving << 1,
+		.cameraTarget = game->camera.target,
+		.prevCameraTarget = game->prevCameraTarget,
+		.score = game->score,
+	};
+	memcpy(words, &state, sizeof(state));
+}
+
+static void ApplyRewindState(Game* game, const uint32_t* words) {
+	RewindState state;
+	memcpy(&state, words, sizeof(state));
+
+	Player* player = game->player;
+	player->frame = state.frame;
+	player->prevPosition = state.prevPosition;
+	player->velocity = state.velocity;
+	player->coyoteTimer = state.coyoteTimer;
+	player->jumpBufferTimer = state.jumpBufferTimer;
+	player->isGrounded = state.flags & 1;
+	player->isMoving = (state.flags >> 1) & 1;
+	game->camera.target = state.cameraTarget;
+	game->prevCameraTarget = state.prevCameraTarget;
+	game->score = state.score;
+}
+
+// Ring copies, in two pieces when they wrap around the end of the buffer
+static void PutRewindBytes(Rewind* rewind, unsigned int at, const unsigned char* bytes, int size) {
+	unsigned int start = at & rewind->mask;
+	int first = rewind->mask + 1 - start < (unsigned int)size ? (int)(rewind->mask + 1 - start) : size;
+	memcpy(&rewind->buffer[start], bytes, first);
+	memcpy(rewind->buffer, bytes + first, size - first);
+}
+
+static void GetRewindBytes(Rewind* rewind, unsigned int at, unsigned char* bytes, int size) {
+	unsigned int start = at & rewind->mask;
+	int first = rewind->mask + 1 - start < (unsigned int)size ? (int)(rewind->mask + 1 - start) : size;
+	memcpy(bytes, &rewind->buffer[start], first);
+	memcpy(bytes + first, rewind->buffer, size - first);
+}
+
+static unsigned short GetRewindLength(Rewind* rewind, unsigned int at) {
+	unsigned char bytes[2];
+	GetRewindBytes(rewind, at, bytes, 2);
+	return bytes[0] | bytes[1] << 8;
+}
+
+//-----------------------------------------------------------------------------------------
+
+// Appends the tick StepGame just ran, a few XORs and byte copies
+void RecordRewindTick(Game* game) {
+	Rewind* rewind = game->rewind;
+	if (rewind == ((void*)0)) {
+		return;
+	}
+
+	uint32_t words[REWIND_WORDS];
+	CaptureRewindState(game, words);
+
+	int edits = game->tileEditCount - rewind->editCount;
+	if (!rewind->started || rewind->level != game->level || edits < 0 || edits > REWIND_EDIT_LIMIT || game->tileEditsOverflowed) {
+		// new level or edits that can't be undone from here, history starts over
+		ClearRewind(game);
+		rewind->started = true;
+		rewind->level = game->level;
+		rewind->editCount = game->tileEditCount;
+		memcpy(rewind->last, words, sizeof(words));
+		return;
+	}
+
+	unsigned char record[REWIND_RECORD_MAX];
+	int length = 9; // length, mask, counts and edit count come first
+	unsigned int mask = 0, counts = 0;
+	int changed = 0;
+
+	for (int i = 0; i < REWIND_WORDS; i++) {
+		uint32_t delta = words[i] ^ rewind->last[i];
+		if (delta == 0) {
+			continue;
+		}
+
+		int bytes = 4 - __builtin_clz(delta) / 8;
+		mask |= 1u << i;
+		counts |= (unsigned int)(bytes - 1) << (changed++ * 2);
+		for (int b = 0; b < bytes; b++) {
+			record[length++] = delta >> (b * 8);
+		}
+	}
+
+	for (int i = rewind->editCount; i < game->tileEditCount; i++) {
+		TileEdit* edit = &game->tileEdits[i];
+		int32_t x = edit->x;
+		uint16_t y = edit->y;
+		memcpy(&record[length], &x, 4);
+		memcpy(&record[length + 4], &y, 2);
+		record[length + 6] = edit->before;
+		record[length + 7] = edit->after;
+		length += 8;
+	}
+	length += 2;
+
+	record[0] = length;
+	record[1] = length >> 8;
+	record[2] = mask;
+	record[3] = mask >> 8;
+	memcpy(&record[4], &counts, 4);
+	record[8] = edits;
+	record[length - 2] = length;
+	record[length - 1] = length >> 8;
+
+	// drop the oldest ticks until the record fits
+	while (rewind->head - rewind->tail + length > rewind->mask + 1) {
+		rewind->tail += GetRewindLength(rewind, rewind->tail);
+		rewind->tickCount--;
+	}
+
+	PutRewindBytes(rewind, rewind->head, record, length);
+	rewind->head += length;
+	rewind->tickCount++;
+	rewind->editCount = game->tileEditCount;
+	memcpy(rewind->last, words, sizeof(words));
+}
+
+// Undoes the newest recorded tick, returns false once the history is used up.
+// Endless worlds also stop before the camera leaves the columns still resident
+bool RewindGameTick(Game* game) {
+	Rewind* rewind = game->rewind;
+	if (rewind == ((void*)0) || rewind->tickCount == 0) {
+		return false;
+	}
+	if (game->endless && game->camera.target.x - VIEW_WIDTH < game->originX * TILESIZE) {
+		ClearRewind(game);
+		return false;
+	}
+
+	unsigned char record[REWIND_RECORD_MAX];
+	int length = GetRewindLength(rewind, rewind->head - 2);
+	rewind->head -= length;
+	rewind->tickCount--;
+	GetRewindBytes(rewind, rewind->head, record, length);
+
+	unsigned int mask = record[2] | record[3] << 8;
+	unsigned int counts;
+	memcpy(&counts, &record[4], 4);
+	int edits = record[8];
+
+	int at = 9;
+	int changed = 0;
+	for (int i = 0; i < REWIND_WORDS; i++) {
+		if (!(mask & (1u << i))) {
+			continue;
+		}
+
+		int bytes = ((counts >> (changed++ * 2)) & 3) + 1;
+		uint32_t delta = 0;
+		for (int b = 0; b < bytes; b++) {
+			delta |= (uint32_t)record[at++] << (b * 8);
+		}
+		rewind->last[i] ^= delta;
+	}
+	ApplyRewindState(game, rewind->last);
+
+	// the tick's edits are the newest in the level's log, undo and drop them
+	for (int e = edits - 1; e >= 0; e--) {
+		const unsigned char* edit = &record[at + e * 8];
+		int32_t x;
+		uint16_t y;
+		memcpy(&x, edit, 4);
+		memcpy(&y, edit + 4, 2);
+		RestoreTileAt(game, x, y, edit[6]);
+	}
+	game->tileEditCount -= edits;
+	rewind->editCount = game->tileEditCount;
+
+	return true;
+}
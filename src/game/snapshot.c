@@ -0,0 +1,219 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+
+#include <string.h>
+
+// Snapshot layout: SnapshotState, the object slots and their free list, the bodies, then the
+// level's tile edit log, or the whole resident tilemap once the log had overflowed. The base
+// level itself is regenerated from its seed when needed. Snapshots hold host pointers and
+// padding, they are meant for memory only and never for files
+typedef struct SnapshotState {
+	// shape of the game the snapshot fits
+	int width, height, objectLimit;
+	bool endless;
+
+	// base level
+	uint64_t seed;
+	unsigned short level;
+	bool fromFile; // can't be regenerated, only restored while still loaded
+
+	Theme theme;
+	unsigned short score;
+	Player player;
+	Camera2D camera;
+	Vector2 prevCameraTarget;
+
+	Rng rng;
+	float noiseZ;
+	int holeRun;
+	int originX;
+	int generatedX;
+
+	int objectCount;
+	int objectFreeHead;
+	int bodyCount;
+	int tileEditCount;
+	bool tileEditsOverflowed;
+	uint64_t tileHash;
+} SnapshotState;
+
+//-----------------------------------------------------------------------------------------
+
+static void WriteSnapshot(GameSnapshot* snapshot, const void* bytes, size_t size) {
+	memcpy(snapshot->data + snapshot->size, bytes, size);
+	snapshot->size += size;
+}
+
+static const unsigned char* ReadSnapshot(const unsigned char* at, void* bytes, size_t size) {
+	memcpy(bytes, at, size);
+	return at + size;
+}
+
+// Length of the prefix the game's tile edit log shares with a snapshot's
+static int CountSharedTileEdits(Game* game, const unsigned char* edits, int count) {
+	int shared = 0;
+	while (shared < count && shared < game->tileEditCount) {
+		TileEdit edit, *own = &game->tileEdits[shared];
+		memcpy(&edit, edits + sizeof(TileEdit) * shared, sizeof(edit));
+		if (edit.x != own->x || edit.y != own->y || edit.before != own->before || edit.after != own->after) {
+			break;
+		}
+		shared++;
+	}
+
+	return shared;
+}
+
+// Captures the game at the current tick. The snapshot's buffer is reused and only grows,
+// taking one snapshot after another allocates nothing
+void SnapshotGame(Game* game, GameSnapshot* snapshot) {
+	Bodies* bodies = &game->bodies;
+	SnapshotState state = {
+		.width = game->width,
+		.height = game->height,
+		.objectLimit = game->objectLimit,
+		.endless = game->endless,
+		.seed = game->seed,
+		.level = game->level,
+		.fromFile = game->levelFile != ((void*)0),
+		.theme = game->theme,
+		.score = game->score,
+		.player = *game->player,
+		.camera = game->camera,
+		.prevCameraTarget = game->prevCameraTarget,
+		.rng = game->rng,
+		.noiseZ = game->noiseZ,
+		.holeRun = game->holeRun,
+		.originX = game->originX,
+		.generatedX = game->generatedX,
+		.objectCount = game->objectCount,
+		.objectFreeHead = game->objectFreeHead,
+		.bodyCount = bodies->count,
+		.tileEditCount = game->tileEditsOverflowed ? 0 : game->tileEditCount,
+		.tileEditsOverflowed = game->tileEditsOverflowed,
+		.tileHash = game->tileHash,
+	};
+
+	size_t tileBytes = state.tileEditsOverflowed ? sizeof(Tile) * game->width * game->height : sizeof(TileEdit) * state.tileEditCount;
+	size_t size = sizeof(state) + (sizeof(Object) + sizeof(int)) * state.objectCount + (sizeof(float) * 6 + sizeof(uint8_t)) * state.bodyCount +
+				  tileBytes;
+	if ((int)size > snapshot->capacity) {
+		snapshot->data = MemRealloc(snapshot->data, size);
+		snapshot->capacity = size;
+	}
+	snapshot->size = 0;
+
+	WriteSnapshot(snapshot, &state, sizeof(state));
+	WriteSnapshot(snapshot, game->objects, sizeof(Object) * state.objectCount);
+	WriteSnapshot(snapshot, game->objectNextFree, sizeof(int) * state.objectCount);
+	WriteSnapshot(snapshot, bodies->x, sizeof(float) * state.bodyCount);
+	WriteSnapshot(snapshot, bodies->y, sizeof(float) * state.bodyCount);
+	WriteSnapshot(snapshot, bodies->vx, sizeof(float) * state.bodyCount);
+	WriteSnapshot(snapshot, bodies->vy, sizeof(float) * state.bodyCount);
+	WriteSnapshot(snapshot, bodies->w, sizeof(float) * state.bodyCount);
+	WriteSnapshot(snapshot, bodies->h, sizeof(float) * state.bodyCount);
+	WriteSnapshot(snapshot, bodies->flags, sizeof(uint8_t) * state.bodyCount);
+	WriteSnapshot(snapshot, state.tileEditsOverflowed ? (const void*)game->tilemap : (const void*)game->tileEdits, tileBytes);
+}
+
+// Puts the game back to the snapshot's tick. On the snapshot's own level this only undoes and
+// redoes the tile edits the two don't share, O(snapshot size) at most. Another level, or an endless
+// window that moved, regenerates the base level first. Particles are dropped and object
+// handles turn stale. Returns false if the snapshot doesn't fit this game
+bool RestoreGame(Game* game, const GameSnapshot* snapshot) {
+	SnapshotState state;
+	if (snapshot->size < (int)sizeof(state)) {
+		return false;
+	}
+	const unsigned char* at = ReadSnapshot(snapshot->data, &state, sizeof(state));
+
+	if (state.width != game->width || state.height != game->height || state.objectLimit != game->objectLimit || state.endless != game->endless) {
+		TraceLog(LOG_WARNING, "SNAPSHOT: Taken from a game with another map size or limits");
+		return false;
+	}
+
+	bool sameBase = state.seed == game->seed && state.level == game->level && state.fromFile == (game->levelFile != ((void*)0));
+	bool regenerate = !sameBase || state.generatedX != game->generatedX || (game->tileEditsOverflowed && !state.tileEditsOverflowed);
+	if (regenerate && state.fromFile) {
+		TraceLog(LOG_WARNING, "SNAPSHOT: Level was loaded from a file that is no longer loaded");
+		return false;
+	}
+
+	if (regenerate) {
+		CancelLevelPrefetch(game); // it was seeded from the level being replaced
+		GenerateLevel(game, state.seed);
+		StreamEndlessWorldTo(game, state.generatedX);
+		MarkAllTilesDirty(game);
+	}
+
+	at = ReadSnapshot(at, game->objects, sizeof(Object) * state.objectCount);
+	at = ReadSnapshot(at, game->objectNextFree, sizeof(int) * state.objectCount);
+	game->objectCount = state.objectCount;
+	game->objectFreeHead = state.objectFreeHead;
+	RebuildObjectGrid(game);
+	RenewObjectGenerations(game);
+
+	Bodies* bodies = &game->bodies;
+	at = ReadSnapshot(at, bodies->x, sizeof(float) * state.bodyCount);
+	at = ReadSnapshot(at, bodies->y, sizeof(float) * state.bodyCount);
+	at = ReadSnapshot(at, bodies->vx, sizeof(float) * state.bodyCount);
+	at = ReadSnapshot(at, bodies->vy, sizeof(float) * state.bodyCount);
+	at = ReadSnapshot(at, bodies->w, sizeof(float) * state.bodyCount);
+	at = ReadSnapshot(at, bodies->h, sizeof(float) * state.bodyCount);
+	at = ReadSnapshot(at, bodies->flags, sizeof(uint8_t) * state.bodyCount);
+	bodies->count = state.bodyCount;
+
+	if (state.tileEditsOverflowed) {
+		ReadSnapshot(at, game->tilemap, sizeof(Tile) * game->width * game->height);
+		memset(game->solid, 0, sizeof(uint32_t) * game->solidStride * game->height);
+		BuildSolidBits(game);
+		BuildAutotileCache(game);
+		MarkAllTilesDirty(game);
+		game->tileEditCount = 0;
+	} else {
+		// Both logs start from the same base, only the edits past their shared prefix
+		// are undone and redone. Going back on the same level costs only the edits since
+		int shared = 0;
+		if (!regenerate) {
+			shared = CountSharedTileEdits(game, at, state.tileEditCount);
+			for (int i = game->tileEditCount - 1; i >= shared; i--) {
+				TileEdit* edit = &game->tileEdits[i];
+				RestoreTileAt(game, edit->x, edit->y, edit->before);
+			}
+		}
+
+		ReadSnapshot(at + sizeof(TileEdit) * shared, &game->tileEdits[shared], sizeof(TileEdit) * (state.tileEditCount - shared));
+		for (int i = shared; i < state.tileEditCount; i++) {
+			TileEdit* edit = &game->tileEdits[i];
+			RestoreTileAt(game, edit->x, edit->y, edit->after);
+		}
+		game->tileEditCount = state.tileEditCount;
+	}
+	game->tileEditsOverflowed = state.tileEditsOverflowed;
+	game->tileHash = state.tileHash;
+
+	Animation* anim = game->player->anim; // the animation is cosmetic and not part of the state
+	*game->player = state.player;
+	game->player->anim = anim;
+
+	game->seed = state.seed;
+	game->level = state.level;
+	game->theme = state.theme;
+	game->score = state.score;
+	game->camera = state.camera;
+	game->prevCameraTarget = state.prevCameraTarget;
+	game->rng = state.rng;
+	game->noiseZ = state.noiseZ;
+	game->holeRun = state.holeRun;
+	game->originX = state.originX;
+	game->generatedX = state.generatedX;
+
+	ClearParticles(game);
+	ClearRewind(game); // its deltas lead up to the state just replaced
+	return true;
+}
+
+void UnloadGameSnapshot(GameSnapshot* snapshot) {
+	MemFree(snapshot->data);
+	*snapshot = (GameSnapshot){0};
+}
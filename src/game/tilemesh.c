@@ -0,0 +1,183 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+
+// Quads are laid out column-major so a storage column is one contiguous vertex range:
+// quad index = column * height + y, 6 vertices (2 triangles) per quad
+#define QUAD_VERTS 6
+
+//-----------------------------------------------------------------------------------------
+
+// Whether a game of this size can be drawn, LoadTileMesh refuses bigger ones
+bool IsTileMeshSizeValid(int width, int height) {
+	return (long long)width * height <= TILE_MESH_MAX_TILES;
+}
+
+// The game must pass IsTileMeshSizeValid, callers reject bigger levels up front
+void LoadTileMesh(Game* game) {
+	TileMesh* tm = &game->tileMesh;
+	if (!IsTileMeshSizeValid(game->width, game->height)) {
+		TraceLog(LOG_FATAL, "TILEMESH: %dx%d map is over the %d tile limit", game->width, game->height, TILE_MESH_MAX_TILES);
+		return;
+	}
+	int quadCount = game->width * game->height;
+
+	tm->mesh = (Mesh){0};
+	tm->mesh.vertexCount = quadCount * QUAD_VERTS;
+	tm->mesh.triangleCount = quadCount * 2;
+	tm->mesh.vertices = MemAlloc(sizeof(float) * 3 * tm->mesh.vertexCount);	// zeroed, every quad starts degenerate
+	tm->mesh.texcoords = MemAlloc(sizeof(float) * 2 * tm->mesh.vertexCount);
+	UploadMesh(&tm->mesh, true); // dynamic, tiles get rewritten in place
+
+	tm->material = LoadMaterialDefault();
+	tm->material.maps[MATERIAL_MAP_DIFFUSE].texture = txAtlas;
+
+	tm->dirtyRows = ArenaAlloc(&game->arena, sizeof(TileRows) * game->width);
+	MarkAllTilesDirty(game);
+}
+
+void UnloadTileMesh(Game* game) {
+	TileMesh* tm = &game->tileMesh;
+
+	UnloadMesh(tm->mesh); // also frees the CPU side vertex arrays
+
+	// Only free the maps, UnloadMaterial would also unload the shared atlas texture
+	MemFree(tm->material.maps);
+	tm->material = (Material){0};
+
+	tm->dirtyRows = ((void*)0); // arena memory, stays until DestroyGame
+}
+
+// Schedules the quads of rows top..bottom (inclusive) in world column x for upload,
+// does nothing if the column isn't resident
+void MarkTileRowsDirty(Game* game, int x, int top, int bottom) {
+	if (game->tileMesh.dirtyRows == ((void*)0) || !IsTileInBounds(game, x, 0)) {
+		return;
+	}
+
+	TileRows* rows = &game->tileMesh.dirtyRows[x & game->wrapMask];
+	top = top < 0 ? 0 : top;
+	bottom = bottom >= game->height ? game->height : bottom + 1;
+	if (top >= bottom) {
+		return;
+	}
+
+	if (rows->top >= rows->bottom) {
+		*rows = (TileRows){top, bottom};
+	} else {
+		rows->top = top < rows->top ? top : rows->top;
+		rows->bottom = bottom > rows->bottom ? bottom : rows->bottom;
+	}
+}
+
+void MarkTileColumnDirty(Game* game, int x) {
+	MarkTileRowsDirty(game, x, 0, game->height - 1);
+}
+
+void MarkAllTilesDirty(Game* game) {
+	if (game->tileMesh.dirtyRows == ((void*)0)) {
+		return; // headless, nothing to draw
+	}
+
+	for (int i = 0; i < game->width; i++) {
+		game->tileMesh.dirtyRows[i] = (TileRows){0, game->height};
+	}
+}
+
+// Rewrites positions and atlas UVs for the quads of rows top..bottom-1 in storage column col
+static void WriteColumnQuads(Game* game, int col, int top, int bottom) {
+	TileMesh* tm = &game->tileMesh;
+
+	// World column currently stored in this slot of the ring
+	int x = game->originX + ((col - game->originX) & game->wrapMask);
+	Rectangle sheet = atlasRegions[ATLAS_REGION_TILES];
+
+	for (int y = top; y < bottom; y++) {
+		int idx = TILE_INDEX(game, x, y);
+		int base = (col * game->height + y) * QUAD_VERTS;
+		float* v = &tm->mesh.vertices[base * 3];
+		float* uv = &tm->mesh.texcoords[base * 2];
+
+		if (game->tilemap[idx].id == TILE_ID_NONE) {
+			// Collapse the quad to a point so it rasterizes nothing
+			for (int i = 0; i < QUAD_VERTS * 3; i++) {
+				v[i] = 0.0f;
+			}
+			continue;
+		}
+
+		int tileVariant = 3 * (game->tilemap[idx].id - 1);
+		int tileDir = game->autotile[idx];
+
+		float x0 = x * TILESIZE;
+		float y0 = y * TILESIZE;
+		float x1 = x0 + TILESIZE;
+		float y1 = y0 + TILESIZE;
+
+		float u0 = (sheet.x + (tileVariant + (tileDir % 3)) * TILESIZE) / txAtlas.width;
+		float v0 = (sheet.y + (tileDir / 3) * TILESIZE) / txAtlas.height;
+		float u1 = u0 + (float)TILESIZE / txAtlas.width;
+		float v1 = v0 + (float)TILESIZE / txAtlas.height;
+
+		// top-left, bottom-left, bottom-right / top-left, bottom-right, top-right,
+		// same winding as raylib's own textured quads so backface culling keeps them
+		const float quadPos[QUAD_VERTS][2] = {{x0, y0}, {x0, y1}, {x1, y1}, {x0, y0}, {x1, y1}, {x1, y0}};
+		const float quadUV[QUAD_VERTS][2] = {{u0, v0}, {u0, v1}, {u1, v1}, {u0, v0}, {u1, v1}, {u1, v0}};
+
+		for (int i = 0; i < QUAD_VERTS; i++) {
+			v[i * 3 + 0] = quadPos[i][0];
+			v[i * 3 + 1] = quadPos[i][1];
+			v[i * 3 + 2] = 0.0f;
+			uv[i * 2 + 0] = quadUV[i][0];
+			uv[i * 2 + 1] = quadUV[i][1];
+		}
+	}
+}
+
+// Rewrites the CPU side quads of every column without touching the GPU,
+// safe to call from a worker thread on a game that is not being drawn
+void WriteAllTileQuads(Game* game) {
+	for (int col = 0; col < game->width; col++) {
+		WriteColumnQuads(game, col, 0, game->height);
+	}
+}
+
+// Uploads the dirty rows of every column. A column whose rows reach its bottom continues into
+// the next one's top in vertex order, such runs (streamed or regenerated columns) go up as a
+// single buffer update. Must run on the render side, the simulation only flags rows
+void UpdateTileMesh(Game* game) {
+	TileMesh* tm = &game->tileMesh;
+
+	// Vertex arrays were swapped in already written, only the GPU copy is stale
+	if (tm->uploadAll) {
+		UpdateMeshBuffer(tm->mesh, 0, tm->mesh.vertices, sizeof(float) * 3 * tm->mesh.vertexCount, 0);
+		UpdateMeshBuffer(tm->mesh, 1, tm->mesh.texcoords, sizeof(float) * 2 * tm->mesh.vertexCount, 0);
+		tm->uploadAll = false;
+	}
+
+	int col = 0;
+	while (col < game->width) {
+		TileRows* rows = &tm->dirtyRows[col];
+		if (rows->top >= rows->bottom) {
+			col++;
+			continue;
+		}
+
+		int first = col * game->height + rows->top; // quad range of the update
+		int last = first;
+		bool joined = true;
+		while (joined) {
+			WriteColumnQuads(game, col, rows->top, rows->bottom);
+			last = col * game->height + rows->bottom;
+			joined = rows->bottom == game->height && col + 1 < game->width && rows[1].top == 0 && rows[1].bottom > 0;
+
+			*rows = (TileRows){0, 0};
+			rows++;
+			col++;
+		}
+
+		int offset = first * QUAD_VERTS;
+		int count = (last - first) * QUAD_VERTS;
+		UpdateMeshBuffer(tm->mesh, 0, &tm->mesh.vertices[offset * 3], sizeof(float) * 3 * count, sizeof(float) * 3 * offset);
+		UpdateMeshBuffer(tm->mesh, 1, &tm->mesh.texcoords[offset * 2], sizeof(float) * 2 * count, sizeof(float) * 2 * offset);
+	}
+}
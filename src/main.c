@@ -3,32 +3,133 @@
 
 #ifdef __EMSCRIPTEN__
 #include "emscripten/emscripten.h"
+#else
+#include <stdio.h>
+#include <time.h>
 #endif
 
 Game game = {0};
+Replay replay = {0};
+
+// Startup benchmark, time to the first presented frame
+double startupMs = 0.0;
+double assetsMs = 0.0;
+bool firstFrame = true;
+bool startupBench = false; // print the first frame time and quit
+
+// Milliseconds on a clock that starts with the page on the web, so download and
+// instantiation count too. Natively it's measured from the start of main
+double GetStartupClock() {
+#ifdef __EMSCRIPTEN__
+	return emscripten_get_now();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+#endif
+}
 
 void RunStepFrame() {
 	UpdateDrawGame(&game);
+
+	if (firstFrame) {
+		firstFrame = false;
+		double elapsed = GetStartupClock() - startupMs;
+		TraceLog(LOG_INFO, "STARTUP: First frame after %.1f ms, assets took %.1f ms", elapsed, assetsMs);
+#ifndef __EMSCRIPTEN__
+		if (startupBench) {
+			printf("first frame: %.2f ms\nassets:      %.2f ms\n", elapsed, assetsMs);
+		}
+#endif
+	}
 }
 
-int main(void) {
-	InitWindow(640, 360, "Jumpy Dumpy");
+// usage: jumpy-dumpy [--endless | --level file] [--record file | --replay file] [--startup-bench]
+// On the web, level files are read from the embedded assets directory
+int main(int argc, char** argv) {
+#ifndef __EMSCRIPTEN__
+	startupMs = GetStartupClock();
+#endif
+	bool endless = false;
+	const char* recordFile = ((void*)0);
+	const char* replayFile = ((void*)0);
+	const char* levelFile = ((void*)0);
+
+	for (int i = 1; i < argc; i++) {
+		if (TextIsEqual(argv[i], "--endless")) {
+			endless = true;
+		} else if (TextIsEqual(argv[i], "--record") && i + 1 < argc) {
+			recordFile = argv[++i];
+		} else if (TextIsEqual(argv[i], "--replay") && i + 1 < argc) {
+			replayFile = argv[++i];
+		} else if (TextIsEqual(argv[i], "--level") && i + 1 < argc) {
+			levelFile = argv[++i];
+		} else if (TextIsEqual(argv[i], "--startup-bench")) {
+			startupBench = true;
+		}
+	}
+
+	SetConfigFlags(FLAG_VSYNC_HINT); // render at the display rate, the simulation has its own fixed rate
+	InitWindow(VIEW_WIDTH, VIEW_HEIGHT, "Jumpy Dumpy");
 
+	double assetsStart = GetStartupClock();
 	LoadAssetsGame();
+	assetsMs = GetStartupClock() - assetsStart;
+
+	if (replayFile != ((void*)0) && LoadReplay(&replay, replayFile) && !IsTileMeshSizeValid(replay.width, replay.height)) {
+		TraceLog(LOG_WARNING, "REPLAY: [%s] %dx%d is too big to draw, the limit is %d tiles", replayFile, replay.width, replay.height, TILE_MESH_MAX_TILES);
+		UnloadReplay(&replay); // falls back to a generated level
+	}
+
+	if (replay.mode == REPLAY_PLAYBACK) {
+		game = NewGameFromReplay(&replay);
+		game.replay = &replay;
+	} else {
+		int width = 80, height = 40;
+		if (levelFile != ((void*)0) && !GetLevelFileSize(levelFile, &width, &height)) {
+			levelFile = ((void*)0); // falls back to a generated level
+		} else if (levelFile != ((void*)0) && !IsTileMeshSizeValid(width, height)) {
+			TraceLog(LOG_WARNING, "LEVEL: [%s] %dx%d is too big to draw, the limit is %d tiles", levelFile, width, height, TILE_MESH_MAX_TILES);
+			levelFile = ((void*)0);
+			width = 80;
+			height = 40;
+		}
 
-	game = NewGame(80, 40, 16);
-	NewLevel(&game);
+		if (endless) {
+			game = NewEndlessGame(128, 40, 16);
+		} else {
+			game = NewGame(width, height, 16);
+		}
+		if (endless || levelFile == ((void*)0) || !LoadLevelFile(&game, levelFile)) {
+			NewLevel(&game);
+		}
+
+		if (recordFile != ((void*)0)) {
+			StartReplayRecording(&replay, &game);
+			game.replay = &replay;
+		} else {
+			LoadRewind(&game, REWIND_BUFFER_SIZE); // hold R to rewind
+		}
+	}
+	LoadGameRenderer(&game);
 
 #ifdef __EMSCRIPTEN__
-	emscripten_set_main_loop(RunStepFrame, 60, 1);
+	emscripten_set_main_loop(RunStepFrame, 0, 1); // 0 = requestAnimationFrame
 #else
-	SetTargetFPS(60);
-	while (!WindowShouldClose()) {
-		UpdateDrawGame(&game);
+	while (!WindowShouldClose() && !(startupBench && !firstFrame)) {
+		RunStepFrame();
 	}
 #endif
 
+	if (replay.mode == REPLAY_RECORD) {
+		SaveReplay(&replay, recordFile);
+	} else if (replay.mode == REPLAY_PLAYBACK) {
+		TraceLog(LOG_INFO, "REPLAY: %d/%d ticks played, %d out of sync", replay.cursor, replay.tickCount, replay.mismatches);
+	}
+	UnloadReplay(&replay);
+
+	UnloadGameRenderer(&game);
 	UnloadAssetsGame();
 	DestroyGame(&game);
 	CloseWindow();
-}
\ No newline at end of file
+}
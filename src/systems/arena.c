@@ -0,0 +1,132 @@
+#include "raylib.h"
+#include "src/systems/arena.h"
+
+#include <limits.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16
+
+struct ArenaBlock {
+	ArenaBlock* prev;
+	size_t capacity;
+	size_t offset;
+	// data follows, ARENA_ALIGN aligned
+};
+
+#define BLOCK_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define BLOCK_DATA(block) ((unsigned char*)(block) + BLOCK_HEADER)
+
+//-------------------------------------------------------------
+
+// MemAlloc takes an unsigned int, bigger blocks are refused rather than silently truncated
+#define BLOCK_MAX_CAPACITY ((size_t)UINT_MAX - BLOCK_HEADER)
+
+static ArenaBlock* NewArenaBlock(Arena* arena, size_t capacity) {
+	if (capacity > BLOCK_MAX_CAPACITY) {
+		return ((void*)0);
+	}
+
+	ArenaBlock* block = MemAlloc(BLOCK_HEADER + capacity);
+	if (block == ((void*)0)) {
+		return ((void*)0);
+	}
+
+	block->prev = arena->block;
+	block->capacity = capacity;
+	block->offset = 0;
+
+	arena->block = block;
+	arena->reserved += capacity;
+	arena->blockCount++;
+
+	return block;
+}
+
+static void FreeArenaBlocks(Arena* arena, ArenaBlock* until) {
+	while (arena->block != until) {
+		ArenaBlock* prev = arena->block->prev;
+		arena->reserved -= arena->block->capacity;
+		arena->blockCount--;
+		MemFree(arena->block);
+		arena->block = prev;
+	}
+}
+
+Arena NewArena(size_t blockSize) {
+	Arena arena = {0};
+	arena.blockSize = blockSize;
+	NewArenaBlock(&arena, blockSize);
+
+	return arena;
+}
+
+void DestroyArena(Arena* arena) {
+	FreeArenaBlocks(arena, ((void*)0));
+	*arena = (Arena){0};
+}
+
+void* ArenaAlloc(Arena* arena, size_t size) {
+	if (size > BLOCK_MAX_CAPACITY) {
+		TraceLog(LOG_WARNING, "ARENA: %zu bytes is over the %zu byte block limit", size, BLOCK_MAX_CAPACITY);
+		return ((void*)0);
+	}
+	size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+	ArenaBlock* block = arena->block;
+	if (block == ((void*)0) || block->capacity - block->offset < size) {
+		// Out of room, chain a block big enough for this allocation
+		size_t capacity = size > arena->blockSize ? size : arena->blockSize;
+		block = NewArenaBlock(arena, capacity);
+		if (block == ((void*)0)) {
+			TraceLog(LOG_WARNING, "ARENA: Failed to allocate a %zu byte block", capacity);
+			return ((void*)0);
+		}
+	}
+
+	void* ptr = BLOCK_DATA(block) + block->offset;
+	block->offset += size;
+
+	arena->used += size;
+	arena->allocations++;
+	if (arena->used > arena->peak) {
+		arena->peak = arena->used;
+	}
+
+	memset(ptr, 0, size);
+	return ptr;
+}
+
+// O(1) unless the arena had to chain blocks, then they are merged into a single
+// block of the combined size so the next round fits in one again
+void ResetArena(Arena* arena) {
+	if (arena->blockCount > 1) {
+		size_t capacity = arena->reserved;
+		FreeArenaBlocks(arena, ((void*)0));
+		NewArenaBlock(arena, capacity);
+	} else if (arena->block != ((void*)0)) {
+		arena->block->offset = 0;
+	}
+
+	arena->used = 0;
+	arena->allocations = 0;
+}
+
+ArenaMark GetArenaMark(Arena* arena) {
+	return (ArenaMark){
+		arena->block,
+		arena->block != ((void*)0) ? arena->block->offset : 0,
+		arena->used,
+		arena->allocations,
+	};
+}
+
+// Releases everything allocated since the mark, blocks chained after it included
+void RestoreArenaMark(Arena* arena, ArenaMark mark) {
+	FreeArenaBlocks(arena, mark.block);
+	if (arena->block != ((void*)0)) {
+		arena->block->offset = mark.offset;
+	}
+
+	arena->used = mark.used;
+	arena->allocations = mark.allocations;
+}
@@ -0,0 +1,38 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bump allocator. Allocations are carved out of large blocks and never freed one by one,
+// the whole arena is reset or destroyed at once. A full block chains a new one behind it
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct Arena {
+	ArenaBlock* block; // current block, older ones chain behind it
+	size_t blockSize;  // default size of new blocks
+
+	// statistics
+	size_t used;	 // bytes handed out since the last reset, padding included
+	size_t peak;	 // highest used ever
+	size_t reserved; // bytes held in blocks
+	int allocations; // since the last reset
+	int blockCount;
+} Arena;
+
+// Position to roll an arena back to, for scratch allocations
+typedef struct ArenaMark {
+	ArenaBlock* block;
+	size_t offset;
+	size_t used;
+	int allocations;
+} ArenaMark;
+
+Arena NewArena(size_t blockSize);
+void DestroyArena(Arena* arena);
+void* ArenaAlloc(Arena* arena, size_t size); // zeroed and 16-byte aligned like MemAlloc, NULL when it fails
+void ResetArena(Arena* arena);
+ArenaMark GetArenaMark(Arena* arena);
+void RestoreArenaMark(Arena* arena, ArenaMark mark);
+
+#endif // ARENA_H
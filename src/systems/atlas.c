@@ -0,0 +1,68 @@
+#include "raylib.h"
+#include "src/systems/atlas.h"
+
+//-------------------------------------------------------------
+
+// Tries to shelf pack into a size x size square, returns false if it overflows
+static bool PackShelves(const Image* images, const int* order, int count, int padding, int size, Rectangle* rects) {
+	int x = 0;
+	int y = 0;
+	int shelfHeight = 0;
+
+	for (int i = 0; i < count; i++) {
+		const Image* img = &images[order[i]];
+
+		if (x + img->width > size) {
+			// start a new shelf
+			x = 0;
+			y += shelfHeight + padding;
+			shelfHeight = 0;
+		}
+		if (img->width > size || y + img->height > size) {
+			return false;
+		}
+
+		rects[order[i]] = (Rectangle){x, y, img->width, img->height};
+		x += img->width + padding;
+		if (img->height > shelfHeight) {
+			shelfHeight = img->height;
+		}
+	}
+
+	return true;
+}
+
+Image GenImageAtlas(const Image* images, int count, int padding, Rectangle* rects) {
+	// sort indices by height, tallest first (insertion sort, counts are tiny)
+	int* order = MemAlloc(sizeof(int) * count);
+	for (int i = 0; i < count; i++) {
+		int j = i;
+		while (j > 0 && images[order[j - 1]].height < images[i].height) {
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = i;
+	}
+
+	int size = 16;
+	while (!PackShelves(images, order, count, padding, size, rects)) {
+		size <<= 1;
+	}
+	MemFree(order);
+
+	Image atlas = GenImageColor(size, size, BLANK);
+	for (int i = 0; i < count; i++) {
+		Rectangle src = {0, 0, images[i].width, images[i].height};
+		ImageDraw(&atlas, images[i], src, rects[i], WHITE);
+	}
+
+	return atlas;
+}
+
+Texture2D LoadAtlasFromImages(const Image* images, int count, int padding, Rectangle* rects) {
+	Image atlas = GenImageAtlas(images, count, padding, rects);
+	Texture2D texture = LoadTextureFromImage(atlas);
+	UnloadImage(atlas);
+
+	return texture;
+}
@@ -0,0 +1,15 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "raylib.h"
+
+// Packs several images into one texture so sprites from different sheets
+// can share a single draw batch. Images are placed on shelves sorted by height,
+// the atlas grows in powers of two until everything fits.
+// rects receives the sub-rectangle of each image, in input order
+Texture2D LoadAtlasFromImages(const Image* images, int count, int padding, Rectangle* rects);
+
+// Same packing into a CPU image, for cooking the atlas offline
+Image GenImageAtlas(const Image* images, int count, int padding, Rectangle* rects);
+
+#endif // ATLAS_H
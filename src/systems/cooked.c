@@ -0,0 +1,243 @@
+#include "raylib.h"
+#include "src/systems/cooked.h"
+#include "src/systems/rng.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// File layout: CookedImageHeader, regionCount regions as 4 floats each, then the pixels,
+// raw or as (count, RGBA) runs. Fields are stored in host order like level files
+#define COOKED_MAGIC "JDCI"
+#define COOKED_VERSION 1
+#define COOKED_RUN_SIZE 5 // count byte + one pixel
+#define COOKED_MAX_SIDE 16384 // the largest texture current GPUs take, keeps pixel sizes well within MemAlloc
+
+typedef enum CookedEncoding {
+	COOKED_RAW,
+	COOKED_RLE, // sprite sheets are mostly transparent, long runs of one pixel
+} CookedEncoding;
+
+typedef struct CookedImageHeader {
+	char magic[4];
+	uint32_t version;
+	int32_t width;
+	int32_t height;
+	int32_t format; // PixelFormat of the decoded pixels
+	uint32_t encoding;
+	uint32_t regionCount;
+	uint32_t dataSize; // pixel bytes stored
+} CookedImageHeader;
+
+//-----------------------------------------------------------------------------------------
+
+// Writes the runs of count pixels to out (COOKED_RUN_SIZE bytes per pixel at worst),
+// returns the encoded size
+static int EncodePixelRuns(unsigned char* out, const uint32_t* pixels, int count) {
+	int length = 0;
+
+	for (int i = 0; i < count;) {
+		int run = 1;
+		while (run < 255 && i + run < count && pixels[i + run] == pixels[i]) {
+			run++;
+		}
+
+		out[length] = (unsigned char)run;
+		memcpy(&out[length + 1], &pixels[i], 4);
+		length += COOKED_RUN_SIZE;
+		i += run;
+	}
+
+	return length;
+}
+
+// Returns false if the runs don't decode to exactly count pixels
+static bool DecodePixelRuns(uint32_t* pixels, int count, const unsigned char* in, int size) {
+	int decoded = 0;
+
+	for (int at = 0; at + COOKED_RUN_SIZE <= size; at += COOKED_RUN_SIZE) {
+		int run = in[at];
+		if (run == 0 || decoded + run > count) {
+			return false;
+		}
+
+		uint32_t pixel;
+		memcpy(&pixel, &in[at + 1], 4);
+		for (int i = 0; i < run; i++) {
+			pixels[decoded + i] = pixel;
+		}
+		decoded += run;
+	}
+
+	return decoded == count && size % COOKED_RUN_SIZE == 0;
+}
+
+//-----------------------------------------------------------------------------------------
+
+bool SaveCookedImage(Image image, const Rectangle* regions, int regionCount, const char* fileName) {
+	if (image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 || image.mipmaps > 1) {
+		TraceLog(LOG_WARNING, "COOKED: [%s] Only single-level RGBA8 images are cooked", fileName);
+		return false;
+	}
+	if (image.width > COOKED_MAX_SIDE || image.height > COOKED_MAX_SIDE) {
+		TraceLog(LOG_WARNING, "COOKED: [%s] %dx%d is over the %d pixel side limit", fileName, image.width, image.height, COOKED_MAX_SIDE);
+		return false;
+	}
+
+	int pixelCount = image.width * image.height;
+	int rawSize = pixelCount * 4;
+	unsigned char* runs = MemAlloc(pixelCount * COOKED_RUN_SIZE);
+	int runSize = EncodePixelRuns(runs, image.data, pixelCount);
+
+	// runs are only kept when they actually save space
+	bool encoded = runSize < rawSize;
+	CookedImageHeader header = {
+		.magic = COOKED_MAGIC,
+		.version = COOKED_VERSION,
+		.width = image.width,
+		.height = image.height,
+		.format = image.format,
+		.encoding = encoded ? COOKED_RLE : COOKED_RAW,
+		.regionCount = regionCount,
+		.dataSize = encoded ? runSize : rawSize,
+	};
+
+	int size = sizeof(header) + sizeof(Rectangle) * regionCount + header.dataSize;
+	unsigned char* data = MemAlloc(size);
+	unsigned char* at = data;
+
+	memcpy(at, &header, sizeof(header));
+	at += sizeof(header);
+	memcpy(at, regions, sizeof(Rectangle) * regionCount);
+	at += sizeof(Rectangle) * regionCount;
+	memcpy(at, encoded ? runs : (unsigned char*)image.data, header.dataSize);
+
+	bool success = SaveFileData(fileName, data, size);
+	MemFree(data);
+	MemFree(runs);
+
+	return success;
+}
+
+Image LoadCookedImage(const char* fileName, Rectangle* regions, int regionCount) {
+	Image image = {0};
+
+	if (!FileExists(fileName)) {
+		return image; // not cooked, quietly
+	}
+
+	int size = 0;
+	unsigned char* data = LoadFileData(fileName, &size);
+	if (data == ((void*)0)) {
+		return image;
+	}
+
+	// The sizes come from the file, they are bounded before anything is multiplied, allocated or copied
+	CookedImageHeader header;
+	size_t headerBytes = sizeof(header) + sizeof(Rectangle) * regionCount;
+	bool valid = (size_t)size >= headerBytes;
+	if (valid) {
+		memcpy(&header, data, sizeof(header));
+		valid = memcmp(header.magic, COOKED_MAGIC, 4) == 0 && header.version == COOKED_VERSION &&
+				header.format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 && header.width > 0 && header.height > 0 &&
+				header.width <= COOKED_MAX_SIDE && header.height <= COOKED_MAX_SIDE &&
+				header.regionCount == (uint32_t)regionCount && header.dataSize == (size_t)size - headerBytes;
+	}
+
+	// the stored pixels must be able to fill the image before it is allocated
+	int pixelCount = valid ? header.width * header.height : 0; // at most COOKED_MAX_SIDE squared
+	if (valid) {
+		size_t runPixels = (size_t)header.dataSize / COOKED_RUN_SIZE * 255;
+		valid = (header.encoding == COOKED_RAW && header.dataSize == (size_t)pixelCount * 4) ||
+				(header.encoding == COOKED_RLE && runPixels >= (size_t)pixelCount);
+	}
+
+	if (valid) {
+		const unsigned char* pixels = data + headerBytes;
+		image.data = MemAlloc((size_t)pixelCount * 4);
+
+		if (header.encoding == COOKED_RAW) {
+			memcpy(image.data, pixels, header.dataSize);
+		} else if (!DecodePixelRuns(image.data, pixelCount, pixels, header.dataSize)) {
+			MemFree(image.data);
+			image.data = ((void*)0);
+			valid = false;
+		}
+	}
+
+	if (!valid) {
+		TraceLog(LOG_WARNING, "COOKED: [%s] Not a usable version %d cooked image", fileName, COOKED_VERSION);
+		UnloadFileData(data);
+		return image;
+	}
+
+	memcpy(regions, data + sizeof(header), sizeof(Rectangle) * regionCount);
+	image.width = header.width;
+	image.height = header.height;
+	image.format = header.format;
+	image.mipmaps = 1;
+
+	UnloadFileData(data);
+	return image;
+}
+
+// Manifest lines are "<cooked file> <format> <WxH> <bytes> <source>:<hash>...", hashes are
+// HashBytes of the whole source file in hex
+bool IsCookedFileCurrent(const char* manifestFile, const char* cookedFile) {
+	if (!FileExists(manifestFile)) {
+		return false; // not cooked, quietly
+	}
+
+	char* text = LoadFileText(manifestFile);
+	if (text == ((void*)0)) {
+		return false;
+	}
+
+	const char* name = GetFileName(cookedFile);
+	size_t nameLength = strlen(name);
+	bool listed = false;
+	bool current = true;
+
+	for (char* line = text; line != ((void*)0) && !listed;) {
+		char* next = strchr(line, '\n');
+		if (next != ((void*)0)) {
+			*next++ = '\0';
+		}
+
+		if (strncmp(line, name, nameLength) == 0 && line[nameLength] == ' ') {
+			listed = true;
+
+			for (char* field = strtok(line, " \r"); field != ((void*)0) && current; field = strtok(((void*)0), " \r")) {
+				char* separator = strrchr(field, ':');
+				if (separator == ((void*)0)) {
+					continue; // not a source
+				}
+
+				char* end = ((void*)0);
+				uint64_t hash = strtoull(separator + 1, &end, 16);
+				*separator = '\0';
+				if (end == separator + 1 || *end != '\0') {
+					TraceLog(LOG_WARNING, "COOKED: [%s] Unreadable hash for %s in %s", cookedFile, field, manifestFile);
+					current = false;
+				} else if (FileExists(field)) {
+					int size = 0;
+					unsigned char* source = LoadFileData(field, &size);
+					if (source == ((void*)0) || HashBytes(source, size, 0) != hash) {
+						TraceLog(LOG_WARNING, "COOKED: [%s] %s changed since it was cooked", cookedFile, field);
+						current = false;
+					}
+					UnloadFileData(source);
+				}
+			}
+		}
+
+		line = next;
+	}
+
+	if (!listed) {
+		TraceLog(LOG_WARNING, "COOKED: [%s] Not listed in %s", cookedFile, manifestFile);
+	}
+
+	UnloadFileText(text);
+	return listed && current;
+}
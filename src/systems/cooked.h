@@ -0,0 +1,20 @@
+#ifndef COOKED_H
+#define COOKED_H
+
+#include "raylib.h"
+
+// Images cooked offline into GPU-ready pixels plus a table of named regions, loading one
+// is a file read and at most a run-length decode, no PNG inflate or atlas packing.
+// Only 32-bit RGBA images are cooked
+bool SaveCookedImage(Image image, const Rectangle* regions, int regionCount, const char* fileName);
+
+// regions receives the stored regions, the file must hold exactly regionCount of them.
+// Returns an image with NULL data when the file is missing or unusable
+Image LoadCookedImage(const char* fileName, Rectangle* regions, int regionCount);
+
+// Compares the sources listed for cookedFile in the manifest with their hashes at cook time.
+// False when there is no manifest, the file isn't listed or a source changed since. Sources
+// that aren't shipped (the split web build leaves the sheets out) can't be checked and pass
+bool IsCookedFileCurrent(const char* manifestFile, const char* cookedFile);
+
+#endif // COOKED_H
@@ -0,0 +1,136 @@
+#include "src/systems/noise.h"
+
+// Written once against GCC/Clang generic vectors, the compiler lowers them to
+// AVX2 or SSE natively and to SIMD128 under emscripten (-msimd128), or to scalar code
+// on anything else. Contraction into FMA is disabled so every path rounds the same way
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__AVX2__)
+#define NOISE_LANES 8
+#else
+#define NOISE_LANES 4
+#endif
+
+typedef float vfloat __attribute__((vector_size(NOISE_LANES * 4)));
+typedef int32_t vint __attribute__((vector_size(NOISE_LANES * 4)));
+typedef uint32_t vuint __attribute__((vector_size(NOISE_LANES * 4)));
+
+//-------------------------------------------------------------
+
+// mask lanes are all ones or all zeros, as produced by vector comparisons
+static inline vfloat Select(vint mask, vfloat a, vfloat b) {
+	return (vfloat)((mask & (vint)a) | (~mask & (vint)b));
+}
+
+static inline vint Floor(vfloat v, vfloat* frac) {
+	vint i = __builtin_convertvector(v, vint); // truncates toward zero
+	vfloat f = __builtin_convertvector(i, vfloat);
+	i += (f > v); // comparison lanes are -1 where truncation rounded up
+	*frac = v - __builtin_convertvector(i, vfloat);
+	return i;
+}
+
+static inline vfloat Fade(vfloat t) {
+	return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static inline vuint Hash(vint x, vint y, vint z, uint32_t seed) {
+	vuint h = (vuint)x * 0x8da6b343u ^ (vuint)y * 0xd8163841u ^ (vuint)z * 0xcb1ab31fu ^ seed;
+	h ^= h >> 15;
+	h *= 0x2c1b3c6du;
+	h ^= h >> 12;
+	h *= 0x297a2d39u;
+	h ^= h >> 15;
+	return h;
+}
+
+// Ken Perlin's 12 edge gradients (16 with repeats) picked from the hash without branches
+static inline vfloat Grad(vuint h, vfloat x, vfloat y, vfloat z) {
+	vint hi = (vint)(h & 15u);
+	vfloat u = Select(hi < 8, x, y);
+	vfloat v = Select(hi < 4, y, Select((hi == 12) | (hi == 14), x, z));
+
+	// flip signs by xoring the float sign bit with hash bits 0 and 1
+	u = (vfloat)((vuint)u ^ ((h & 1u) << 31));
+	v = (vfloat)((vuint)v ^ ((h & 2u) << 30));
+	return u + v;
+}
+
+static inline vfloat Lerp(vfloat a, vfloat b, vfloat t) {
+	return a + t * (b - a);
+}
+
+static vfloat GradientNoise(vfloat x, vfloat y, vfloat z, uint32_t seed) {
+	vfloat fx, fy, fz;
+	vint ix = Floor(x, &fx);
+	vint iy = Floor(y, &fy);
+	vint iz = Floor(z, &fz);
+
+	vfloat u = Fade(fx);
+	vfloat v = Fade(fy);
+	vfloat w = Fade(fz);
+
+	vint ix1 = ix + 1;
+	vint iy1 = iy + 1;
+	vint iz1 = iz + 1;
+
+	vfloat n000 = Grad(Hash(ix, iy, iz, seed), fx, fy, fz);
+	vfloat n100 = Grad(Hash(ix1, iy, iz, seed), fx - 1.0f, fy, fz);
+	vfloat n010 = Grad(Hash(ix, iy1, iz, seed), fx, fy - 1.0f, fz);
+	vfloat n110 = Grad(Hash(ix1, iy1, iz, seed), fx - 1.0f, fy - 1.0f, fz);
+	vfloat n001 = Grad(Hash(ix, iy, iz1, seed), fx, fy, fz - 1.0f);
+	vfloat n101 = Grad(Hash(ix1, iy, iz1, seed), fx - 1.0f, fy, fz - 1.0f);
+	vfloat n011 = Grad(Hash(ix, iy1, iz1, seed), fx, fy - 1.0f, fz - 1.0f);
+	vfloat n111 = Grad(Hash(ix1, iy1, iz1, seed), fx - 1.0f, fy - 1.0f, fz - 1.0f);
+
+	vfloat nx00 = Lerp(n000, n100, u);
+	vfloat nx10 = Lerp(n010, n110, u);
+	vfloat nx01 = Lerp(n001, n101, u);
+	vfloat nx11 = Lerp(n011, n111, u);
+
+	return Lerp(Lerp(nx00, nx10, v), Lerp(nx01, nx11, v), w);
+}
+
+//-------------------------------------------------------------
+
+void NoiseFbmRow(float* out, int count, float x0, float dx, float y, float z, NoiseParams params) {
+	vfloat laneOffsets;
+	for (int l = 0; l < NOISE_LANES; l++) {
+		laneOffsets[l] = (float)l;
+	}
+
+	// normalize so the sum of all octave amplitudes is 1
+	float amplitudeSum = 0.0f;
+	float a = 1.0f;
+	for (int o = 0; o < params.octaves; o++) {
+		amplitudeSum += a;
+		a *= params.gain;
+	}
+	float scale = amplitudeSum > 0.0f ? 1.0f / amplitudeSum : 0.0f;
+
+	for (int i = 0; i < count; i += NOISE_LANES) {
+		vfloat xs = x0 + ((float)i + laneOffsets) * dx;
+		vfloat sum = (vfloat){0};
+		float frequency = 1.0f;
+		float amplitude = 1.0f;
+
+		for (int o = 0; o < params.octaves; o++) {
+			vfloat ys = (vfloat){0} + y * frequency;
+			vfloat zs = (vfloat){0} + z * frequency;
+			sum += GradientNoise(xs * frequency, ys, zs, params.seed + (uint32_t)o) * amplitude;
+			frequency *= params.lacunarity;
+			amplitude *= params.gain;
+		}
+		sum *= scale;
+
+		// the last block may be partial
+		int n = count - i < NOISE_LANES ? count - i : NOISE_LANES;
+		for (int l = 0; l < n; l++) {
+			out[i + l] = sum[l];
+		}
+	}
+}
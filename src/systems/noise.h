@@ -0,0 +1,19 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdint.h>
+
+// Fractal sum of 3D gradient (Perlin style) noise
+typedef struct NoiseParams {
+	uint32_t seed;
+	int octaves;	  // 1 = plain gradient noise
+	float lacunarity; // frequency multiplier per octave
+	float gain;		  // amplitude multiplier per octave
+} NoiseParams;
+
+// Fills out[i] with fBm noise sampled at (x0 + i * dx, y, z), roughly in [-1..1].
+// Evaluates several samples per instruction (AVX2/SSE natively, SIMD128 on the web),
+// results are identical on every path
+void NoiseFbmRow(float* out, int count, float x0, float dx, float y, float z, NoiseParams params);
+
+#endif // NOISE_H
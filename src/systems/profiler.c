@@ -0,0 +1,208 @@
+#include "src/systems/profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include "raylib.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#ifdef __EMSCRIPTEN__
+#include "emscripten/emscripten.h"
+#endif
+
+typedef struct ProfileZone {
+	const char* name;
+	double start;					  // of the open scope, in ms
+	double frameTime;				  // accumulated over the current frame
+	float history[PROFILER_HISTORY]; // ms per frame
+} ProfileZone;
+
+typedef struct ProfileEvent {
+	int zone;
+	double start;
+	double duration;
+} ProfileEvent;
+
+static struct {
+	ProfileZone zones[PROFILER_MAX_ZONES];
+	int zoneCount;
+
+	float frameHistory[PROFILER_HISTORY]; // whole frame in ms
+	double frameStart;
+	int frame; // frames completed, history slot = frame % PROFILER_HISTORY
+
+	ProfileEvent events[PROFILER_MAX_EVENTS]; // ring, the newest overwrite the oldest
+	int eventNext;							  // slot of the next event
+	int eventCount;							  // events held, stops growing once the ring is full
+} profiler = {0};
+
+//-------------------------------------------------------------
+
+// Milliseconds from a monotonic clock, independent of the window so headless runs can profile too
+static double GetProfilerTime(void) {
+#ifdef __EMSCRIPTEN__
+	return emscripten_get_now();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+#endif
+}
+
+// Zones are keyed by the literal's address, the list is short so a linear scan wins
+static int GetZoneIndex(const char* name) {
+	for (int i = 0; i < profiler.zoneCount; i++) {
+		if (profiler.zones[i].name == name) {
+			return i;
+		}
+	}
+
+	if (profiler.zoneCount >= PROFILER_MAX_ZONES) {
+		return -1;
+	}
+
+	profiler.zones[profiler.zoneCount] = (ProfileZone){.name = name};
+	return profiler.zoneCount++;
+}
+
+void ProfilerBegin(const char* zone) {
+	int i = GetZoneIndex(zone);
+	if (i >= 0) {
+		profiler.zones[i].start = GetProfilerTime();
+	}
+}
+
+void ProfilerEnd(const char* zone) {
+	double now = GetProfilerTime();
+	int i = GetZoneIndex(zone);
+	if (i < 0) {
+		return;
+	}
+
+	ProfileZone* z = &profiler.zones[i];
+	z->frameTime += now - z->start;
+	profiler.events[profiler.eventNext] = (ProfileEvent){i, z->start, now - z->start};
+	profiler.eventNext = (profiler.eventNext + 1) % PROFILER_MAX_EVENTS;
+	if (profiler.eventCount < PROFILER_MAX_EVENTS) {
+		profiler.eventCount++;
+	}
+}
+
+void ProfilerEndFrame(void) {
+	double now = GetProfilerTime();
+	int slot = profiler.frame % PROFILER_HISTORY;
+
+	profiler.frameHistory[slot] = profiler.frameStart > 0.0 ? (float)(now - profiler.frameStart) : 0.0f;
+	profiler.frameStart = now;
+
+	for (int i = 0; i < profiler.zoneCount; i++) {
+		profiler.zones[i].history[slot] = (float)profiler.zones[i].frameTime;
+		profiler.zones[i].frameTime = 0.0;
+	}
+
+	profiler.frame++;
+}
+
+//-------------------------------------------------------------
+
+static void GetHistoryStats(const float* history, float* average, float* max) {
+	int count = profiler.frame < PROFILER_HISTORY ? profiler.frame : PROFILER_HISTORY;
+	float sum = 0.0f;
+	*max = 0.0f;
+
+	for (int i = 0; i < count; i++) {
+		sum += history[i];
+		if (history[i] > *max) {
+			*max = history[i];
+		}
+	}
+	*average = count > 0 ? sum / count : 0.0f;
+}
+
+// Per-zone rolling average and max over the history, and a frame-time graph with a 60 fps line
+void DrawProfilerOverlay(int x, int y) {
+	const int lineHeight = 12;
+	const int graphHeight = 60;
+	int height = (profiler.zoneCount + 1) * lineHeight + graphHeight + 12;
+
+	DrawRectangle(x, y, PROFILER_HISTORY + 8, height, Fade(BLACK, 0.7f));
+
+	float average, max;
+	GetHistoryStats(profiler.frameHistory, &average, &max);
+	DrawText(TextFormat("frame      %6.2f avg %6.2f max ms", average, max), x + 4, y + 4, 10, RAYWHITE);
+
+	for (int i = 0; i < profiler.zoneCount; i++) {
+		GetHistoryStats(profiler.zones[i].history, &average, &max);
+		DrawText(TextFormat("%-10s %6.2f avg %6.2f max", profiler.zones[i].name, average, max), x + 4, y + 4 + (i + 1) * lineHeight, 10,
+				 LIGHTGRAY);
+	}
+
+	// One bar per frame, oldest on the left, scaled so 33 ms fills the graph
+	int graphBottom = y + height - 4;
+	const float msToPixels = graphHeight / 33.3f;
+	int count = profiler.frame < PROFILER_HISTORY ? profiler.frame : PROFILER_HISTORY;
+	for (int i = 0; i < count; i++) {
+		float ms = profiler.frameHistory[(profiler.frame - count + i) % PROFILER_HISTORY];
+		int barHeight = (int)(ms * msToPixels);
+		if (barHeight > graphHeight) {
+			barHeight = graphHeight;
+		}
+		DrawRectangle(x + 4 + i, graphBottom - barHeight, 1, barHeight, ms > 16.7f ? RED : GREEN);
+	}
+	DrawLine(x + 4, graphBottom - (int)(16.7f * msToPixels), x + 4 + PROFILER_HISTORY, graphBottom - (int)(16.7f * msToPixels), YELLOW);
+}
+
+// One row per frame in the history, oldest first: frame, frame ms, then ms per zone
+bool ExportProfilerCsv(const char* fileName) {
+	FILE* file = fopen(fileName, "w");
+	if (file == ((void*)0)) {
+		TraceLog(LOG_WARNING, "PROFILER: [%s] Failed to open for writing", fileName);
+		return false;
+	}
+
+	fprintf(file, "frame,frame_ms");
+	for (int i = 0; i < profiler.zoneCount; i++) {
+		fprintf(file, ",%s_ms", profiler.zones[i].name);
+	}
+	fprintf(file, "\n");
+
+	int count = profiler.frame < PROFILER_HISTORY ? profiler.frame : PROFILER_HISTORY;
+	for (int f = profiler.frame - count; f < profiler.frame; f++) {
+		int slot = f % PROFILER_HISTORY;
+		fprintf(file, "%d,%.4f", f, profiler.frameHistory[slot]);
+		for (int i = 0; i < profiler.zoneCount; i++) {
+			fprintf(file, ",%.4f", profiler.zones[i].history[slot]);
+		}
+		fprintf(file, "\n");
+	}
+
+	fclose(file);
+	TraceLog(LOG_INFO, "PROFILER: [%s] Exported %d frames", fileName, count);
+	return true;
+}
+
+// Complete ("X") events in microseconds, the most recent PROFILER_MAX_EVENTS zone timings
+bool ExportProfilerTrace(const char* fileName) {
+	FILE* file = fopen(fileName, "w");
+	if (file == ((void*)0)) {
+		TraceLog(LOG_WARNING, "PROFILER: [%s] Failed to open for writing", fileName);
+		return false;
+	}
+
+	int count = profiler.eventCount;
+	int first = (profiler.eventNext - count + PROFILER_MAX_EVENTS) % PROFILER_MAX_EVENTS; // oldest held
+	fprintf(file, "{\"traceEvents\":[\n");
+	for (int e = 0; e < count; e++) {
+		ProfileEvent* event = &profiler.events[(first + e) % PROFILER_MAX_EVENTS];
+		fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}%s\n", profiler.zones[event->zone].name,
+				event->start * 1e3, event->duration * 1e3, e + 1 < count ? "," : "");
+	}
+	fprintf(file, "]}\n");
+
+	fclose(file);
+	TraceLog(LOG_INFO, "PROFILER: [%s] Exported %d events", fileName, count);
+	return true;
+}
+
+#endif // ENABLE_PROFILER
@@ -0,0 +1,33 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+
+// Scoped frame profiler. Zones are named by string literals and timed between
+// PROFILE_BEGIN/PROFILE_END, PROFILE_FRAME closes a frame. Everything compiles
+// to nothing unless built with -DENABLE_PROFILER (make PROFILER=1)
+#ifdef ENABLE_PROFILER
+#define PROFILE_BEGIN(zone) ProfilerBegin(zone)
+#define PROFILE_END(zone) ProfilerEnd(zone)
+#define PROFILE_FRAME() ProfilerEndFrame()
+#else
+#define PROFILE_BEGIN(zone) ((void)0)
+#define PROFILE_END(zone) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
+
+#define PROFILER_MAX_ZONES 32
+#define PROFILER_HISTORY 240		// frames kept for averages, the graph and CSV export
+#define PROFILER_MAX_EVENTS 65536 // zone timings kept for trace export
+
+#ifdef ENABLE_PROFILER
+void ProfilerBegin(const char* zone);
+void ProfilerEnd(const char* zone);
+void ProfilerEndFrame(void);
+
+void DrawProfilerOverlay(int x, int y);
+bool ExportProfilerCsv(const char* fileName);
+bool ExportProfilerTrace(const char* fileName); // Chrome trace JSON, open in chrome://tracing or Perfetto
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,63 @@
+#include "src/systems/rng.h"
+
+#include <string.h>
+
+//-------------------------------------------------------------
+
+void SeedRng(Rng* rng, uint64_t seed) {
+	rng->state = 0;
+	rng->inc = (seed << 1) | 1u; // stream selector must be odd
+	NextRng(rng);
+	rng->state += seed;
+	NextRng(rng);
+}
+
+uint32_t NextRng(Rng* rng) {
+	uint64_t old = rng->state;
+	rng->state = old * 6364136223846793005ULL + rng->inc;
+
+	uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+	uint32_t rot = (uint32_t)(old >> 59u);
+	return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+float NextRngFloat(Rng* rng) {
+	return (NextRng(rng) >> 8) * (1.0f / 16777216.0f); // top 24 bits fit a float exactly
+}
+
+int NextRngRange(Rng* rng, int count) {
+	return (int)(((uint64_t)NextRng(rng) * (uint64_t)count) >> 32);
+}
+
+//-------------------------------------------------------------
+
+static uint64_t MixHash(uint64_t h) {
+	// splitmix64 finalizer
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebULL;
+	h ^= h >> 31;
+	return h;
+}
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+	const unsigned char* bytes = data;
+	uint64_t h = seed ^ (size * 0x9e3779b97f4a7c15ULL);
+
+	// 8 bytes at a time, memcpy keeps unaligned reads legal
+	while (size >= 8) {
+		uint64_t word;
+		memcpy(&word, bytes, 8);
+		h = (h ^ MixHash(word)) * 0x9e3779b97f4a7c15ULL;
+		h = (h << 31) | (h >> 33);
+		bytes += 8;
+		size -= 8;
+	}
+
+	uint64_t tail = 0;
+	memcpy(&tail, bytes, size);
+	h ^= MixHash(tail ^ size);
+
+	return MixHash(h);
+}
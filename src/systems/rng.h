@@ -0,0 +1,22 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// PCG32 generator, small state so every Game can own one.
+// Same seed = same sequence on every platform, unlike rand()
+typedef struct Rng {
+	uint64_t state;
+	uint64_t inc;
+} Rng;
+
+void SeedRng(Rng* rng, uint64_t seed);
+uint32_t NextRng(Rng* rng);
+float NextRngFloat(Rng* rng);		  // [0, 1)
+int NextRngRange(Rng* rng, int count); // [0, count)
+
+// Fast non-cryptographic 64-bit hash, chain calls by passing the previous result as seed
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed);
+
+#endif // RNG_H
@@ -3,11 +3,19 @@
 
 //-------------------------------------------------------------
 
-Animation* NewAnimationFromSheet(Texture2D texture, unsigned char animCount, unsigned char frameCount, float timeDelay) {
+Animation* NewAnimationFromSheet(Rectangle sheet, unsigned char animCount, unsigned char frameCount, float timeDelay) {
 	Animation* animation = MemAlloc(sizeof(Animation));
+	InitAnimationFromSheet(animation, sheet, animCount, frameCount, timeDelay);
+
+	return animation;
+}
+
+// Same as NewAnimationFromSheet for an animation the caller allocated
+void InitAnimationFromSheet(Animation* animation, Rectangle sheet, unsigned char animCount, unsigned char frameCount, float timeDelay) {
+	animation->origin = (Vector2){sheet.x, sheet.y};
 	animation->size = (Vector2){
-		(unsigned char)(texture.width / frameCount),
-		(unsigned char)(texture.height / animCount),
+		(unsigned char)(sheet.width / frameCount),
+		(unsigned char)(sheet.height / animCount),
 	};
 
 	animation->animationCount = animCount;
@@ -16,8 +24,8 @@ Animation* NewAnimationFromSheet(Texture2D texture, unsigned char animCount, uns
 	animation->currentFrame = 0;
 
 	animation->rect = (Rectangle){
-		0,
-		0,
+		animation->origin.x,
+		animation->origin.y,
 		animation->size.x,
 		animation->size.y,
 	};
@@ -26,8 +34,6 @@ Animation* NewAnimationFromSheet(Texture2D texture, unsigned char animCount, uns
 	animation->timer = 0.0f;
 
 	animation->direction = 1;
-
-	return animation;
 }
 
 void DestroyAnimation(Animation** animation) {
@@ -37,8 +43,8 @@ void DestroyAnimation(Animation** animation) {
 
 void SetAnimation(Animation* animation, unsigned char animId) {
 	animation->currentAnimation = animId;
-	animation->rect.x = animation->currentFrame * animation->size.x;
-	animation->rect.y = animation->currentAnimation * animation->size.y;
+	animation->rect.x = animation->origin.x + animation->currentFrame * animation->size.x;
+	animation->rect.y = animation->origin.y + animation->currentAnimation * animation->size.y;
 }
 
 void UpdateAnimation(Animation* animation, float speedMul) {
@@ -52,8 +58,8 @@ void UpdateAnimation(Animation* animation, float speedMul) {
 			animation->currentFrame = 0;
 		}
 
-		animation->rect.x = animation->currentFrame * animation->size.x;
-		animation->rect.y = animation->currentAnimation * animation->size.y;
+		animation->rect.x = animation->origin.x + animation->currentFrame * animation->size.x;
+		animation->rect.y = animation->origin.y + animation->currentAnimation * animation->size.y;
 	}
 
 	/* flip sprite */
@@ -11,8 +11,10 @@
 //	1. | | | | |
 //	2. | | | | |
 // Use an Enum to denote animation, Im too lazy to implement a binary search...
+// The sheet can be a sub-rectangle of a bigger texture, e.g. an atlas region
 typedef struct Animation {
 	Rectangle rect;
+	Vector2 origin; // top-left of the sheet inside its texture
 	Vector2 size;
 
 	float timeDelay;
@@ -27,7 +29,8 @@ typedef struct Animation {
 	bool direction; // 0 = left, 1 = right
 } Animation;
 
-Animation* NewAnimationFromSheet(Texture2D texture, unsigned char animCount, unsigned char frameCount, float timeDelay);
+Animation* NewAnimationFromSheet(Rectangle sheet, unsigned char animCount, unsigned char frameCount, float timeDelay);
+void InitAnimationFromSheet(Animation* animation, Rectangle sheet, unsigned char animCount, unsigned char frameCount, float timeDelay);
 void DestroyAnimation(Animation** animation);
 void SetAnimation(Animation* animation, unsigned char animId);
 void UpdateAnimation(Animation* animation, float speedMul);
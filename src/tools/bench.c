@@ -0,0 +1,438 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+#include "src/systems/atlas.h"
+#include "src/systems/cooked.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Micro-benchmarks of the hot paths on fixed seeds, reports ns/op percentiles and heap allocations.
+// usage: bench [--gpu]   (--gpu opens a hidden window to also time tilemap drawing)
+
+#define BENCH_SAMPLES 200
+
+typedef void (*BenchFunc)(void* ctx, int i);
+
+//------------------------------------------------------
+// Allocation counting, linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+// so raylib's MemAlloc and every libc allocation goes through here
+//------------------------------------------------------
+
+static long long allocCount = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+	allocCount++;
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+	allocCount++;
+	return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+	allocCount++;
+	return __real_realloc(ptr, size);
+}
+
+//------------------------------------------------------
+
+static double GetNanoseconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int CompareDoubles(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+// Times BENCH_SAMPLES samples of batch calls each, batching keeps the clock's own cost out of short ops
+static void RunBench(const char* name, BenchFunc func, void* ctx, int batch) {
+	double samples[BENCH_SAMPLES];
+	int op = 0;
+
+	// warm up caches and branch predictors on the same inputs
+	for (int i = 0; i < batch; i++) {
+		func(ctx, op++);
+	}
+
+	long long allocsBefore = allocCount;
+	double total = 0.0;
+	for (int s = 0; s < BENCH_SAMPLES; s++) {
+		double start = GetNanoseconds();
+		for (int i = 0; i < batch; i++) {
+			func(ctx, op++);
+		}
+		samples[s] = (GetNanoseconds() - start) / batch;
+		total += samples[s];
+	}
+	double allocsPerOp = (double)(allocCount - allocsBefore) / (BENCH_SAMPLES * batch);
+
+	qsort(samples, BENCH_SAMPLES, sizeof(double), CompareDoubles);
+	printf("%-34s %12.1f ns/op  p50 %12.1f  p90 %12.1f  p99 %12.1f  max %12.1f  %6.2f allocs/op\n", name, total / BENCH_SAMPLES,
+		   samples[BENCH_SAMPLES / 2], samples[BENCH_SAMPLES * 9 / 10], samples[BENCH_SAMPLES * 99 / 100], samples[BENCH_SAMPLES - 1],
+		   allocsPerOp);
+}
+
+//------------------------------------------------------
+// Level generation
+//------------------------------------------------------
+
+static void BenchNewLevel(void* ctx, int i) {
+	NewLevelWithSeed(ctx, 1000 + i);
+}
+
+//------------------------------------------------------
+// Level files, the same generated level stored with raw and with run-length encoded layers
+//------------------------------------------------------
+
+#define BENCH_LEVEL_FILE "bench-level.tmp"
+
+static void BenchLoadLevelFile(void* ctx, int i) {
+	LoadLevelFile(ctx, BENCH_LEVEL_FILE);
+}
+
+static void RunLevelFileBench(int width, int height, bool compact) {
+	Game game = NewGame(width, height, 16);
+	NewLevelWithSeed(&game, 1);
+
+	if (SaveLevelFile(&game, BENCH_LEVEL_FILE, compact)) {
+		RunBench(TextFormat("LoadLevelFile %s %dx%d", compact ? "rle" : "raw", width, height), BenchLoadLevelFile, &game, 4);
+		remove(BENCH_LEVEL_FILE);
+	}
+
+	DestroyGame(&game);
+}
+
+//------------------------------------------------------
+// Player collision, replays a fixed set of positions and velocities over the level
+//------------------------------------------------------
+
+#define TRAJECTORY_STEPS 4096
+
+typedef struct TrajectoryBench {
+	Game* game;
+	Rectangle frames[TRAJECTORY_STEPS];
+	Vector2 velocities[TRAJECTORY_STEPS];
+} TrajectoryBench;
+
+static void LoadTrajectories(TrajectoryBench* bench, Game* game, uint64_t seed) {
+	Rng rng;
+	SeedRng(&rng, seed);
+
+	bench->game = game;
+	for (int i = 0; i < TRAJECTORY_STEPS; i++) {
+		float x = NextRngFloat(&rng) * (game->width - 2) * TILESIZE;
+		float y = NextRngFloat(&rng) * (game->height - 2) * TILESIZE;
+		bench->frames[i] = (Rectangle){x, y, game->player->frame.width, game->player->frame.height};
+		bench->velocities[i] = (Vector2){(NextRngFloat(&rng) - 0.5f) * 6.0f, NextRngFloat(&rng) * 16.0f - 6.0f};
+	}
+}
+
+static void BenchMoveX(void* ctx, int i) {
+	TrajectoryBench* bench = ctx;
+	Player* player = bench->game->player;
+	player->frame = bench->frames[i % TRAJECTORY_STEPS];
+	player->velocity = bench->velocities[i % TRAJECTORY_STEPS];
+	PlayerMoveAndCollideX(player, bench->game);
+}
+
+static void BenchMoveY(void* ctx, int i) {
+	TrajectoryBench* bench = ctx;
+	Player* player = bench->game->player;
+	player->frame = bench->frames[i % TRAJECTORY_STEPS];
+	player->velocity = bench->velocities[i % TRAJECTORY_STEPS];
+	PlayerMoveAndCollideY(player, bench->game);
+}
+
+//------------------------------------------------------
+// Object queries
+//------------------------------------------------------
+
+static void BenchGetObjectAt(void* ctx, int i) {
+	TrajectoryBench* bench = ctx;
+	GetObjectAt(bench->game, bench->frames[i % TRAJECTORY_STEPS]);
+}
+
+static void FillObjects(Game* game, int count, uint64_t seed) {
+	Rng rng;
+	SeedRng(&rng, seed);
+
+	ClearGameObjects(game);
+	for (int i = 0; i < count; i++) {
+		AddGameObject(game, (Object){
+								.id = OBJECT_ID_DOOR,
+								.x = NextRngRange(&rng, game->width * TILESIZE),
+								.y = NextRngRange(&rng, game->height * TILESIZE),
+								.w = 16,
+								.h = 32,
+							});
+	}
+}
+
+//------------------------------------------------------
+// Moving bodies, a patrolling population dropped over the level. Every run of ticks starts
+// over from the same population so the few that fall out of the world don't thin it
+//------------------------------------------------------
+
+#define BODY_BENCH_RUN 64
+
+typedef struct BodyBench {
+	Game* game;
+	unsigned char* start; // copy of the body arrays
+	int count;
+} BodyBench;
+
+static void LoadBodyBench(BodyBench* bench, Game* game, int count, uint64_t seed) {
+	Rng rng;
+	SeedRng(&rng, seed);
+
+	ClearBodies(game);
+	for (int i = 0; i < count; i++) {
+		float x = NextRngFloat(&rng) * (game->width - 2) * TILESIZE;
+		float y = NextRngFloat(&rng) * (game->height / 2) * TILESIZE;
+		float vx = NextRngFloat(&rng) < 0.5f ? -1.5f : 1.5f;
+		AddBody(game, (Rectangle){x, y, 12, 12}, (Vector2){vx, 0.0f}, BODY_GRAVITY | BODY_BOUNCE);
+	}
+
+	// the arrays are one block starting at x
+	size_t size = (sizeof(float) * 6 + sizeof(uint8_t)) * game->bodies.capacity;
+	bench->game = game;
+	bench->start = MemAlloc(size);
+	memcpy(bench->start, game->bodies.x, size);
+	bench->count = count;
+}
+
+static void BenchStepBodies(void* ctx, int i) {
+	BodyBench* bench = ctx;
+	Bodies* bodies = &bench->game->bodies;
+	if (i % BODY_BENCH_RUN == 0) {
+		memcpy(bodies->x, bench->start, (sizeof(float) * 6 + sizeof(uint8_t)) * bodies->capacity);
+		bodies->count = bench->count;
+	}
+	StepBodies(bench->game);
+}
+
+//------------------------------------------------------
+// Save states, taken and restored on the level they were taken on. Restoring two states
+// of the same level in turn undoes or redoes every tile edit between them each time
+//------------------------------------------------------
+
+typedef struct SnapshotBench {
+	Game* game;
+	GameSnapshot snapshots[2];
+	int count; // restored in turn
+} SnapshotBench;
+
+static void BenchSnapshotGame(void* ctx, int i) {
+	SnapshotBench* bench = ctx;
+	SnapshotGame(bench->game, &bench->snapshots[0]);
+}
+
+static void BenchRestoreGame(void* ctx, int i) {
+	SnapshotBench* bench = ctx;
+	RestoreGame(bench->game, &bench->snapshots[i % bench->count]);
+}
+
+//------------------------------------------------------
+// Rewind recording, its cost is the difference between the two ticks
+//------------------------------------------------------
+
+static InputFrame GetBenchInput(int i) {
+	return (InputFrame){.right = (i / 300) % 4 != 3, .left = (i / 300) % 4 == 3, .jumpPressed = i % 40 == 0};
+}
+
+static void BenchStepGame(void* ctx, int i) {
+	StepGame(ctx, GetBenchInput(i));
+}
+
+static void BenchStepGameRewind(void* ctx, int i) {
+	StepGame(ctx, GetBenchInput(i));
+	RecordRewindTick(ctx);
+}
+
+//------------------------------------------------------
+// Atlas loading without the upload, decoding and packing the sheets against reading the
+// atlas cooked from them. Runs from the repository root where the sheets are
+//------------------------------------------------------
+
+#define BENCH_COOKED_FILE "bench-atlas.tmp"
+
+static void BenchAtlasFromSheets(void* ctx, int i) {
+	Image images[ATLAS_REGION_COUNT];
+	Rectangle regions[ATLAS_REGION_COUNT];
+	for (int s = 0; s < ATLAS_REGION_COUNT; s++) {
+		images[s] = LoadImage(atlasSheets[s]);
+	}
+
+	UnloadImage(GenImageAtlas(images, ATLAS_REGION_COUNT, ATLAS_PADDING, regions));
+	for (int s = 0; s < ATLAS_REGION_COUNT; s++) {
+		UnloadImage(images[s]);
+	}
+}
+
+static void BenchAtlasFromCooked(void* ctx, int i) {
+	Rectangle regions[ATLAS_REGION_COUNT];
+	UnloadImage(LoadCookedImage(BENCH_COOKED_FILE, regions, ATLAS_REGION_COUNT));
+}
+
+static void RunAtlasBench(void) {
+	for (int s = 0; s < ATLAS_REGION_COUNT; s++) {
+		if (!FileExists(atlasSheets[s])) {
+			return;
+		}
+	}
+
+	Image images[ATLAS_REGION_COUNT];
+	Rectangle regions[ATLAS_REGION_COUNT];
+	for (int s = 0; s < ATLAS_REGION_COUNT; s++) {
+		images[s] = LoadImage(atlasSheets[s]);
+		ImageFormat(&images[s], PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+	}
+	Image atlas = GenImageAtlas(images, ATLAS_REGION_COUNT, ATLAS_PADDING, regions);
+
+	RunBench("Atlas from sheets", BenchAtlasFromSheets, ((void*)0), 1);
+	if (SaveCookedImage(atlas, regions, ATLAS_REGION_COUNT, BENCH_COOKED_FILE)) {
+		RunBench(TextFormat("Atlas from cooked (%d bytes)", GetFileLength(BENCH_COOKED_FILE)), BenchAtlasFromCooked, ((void*)0), 1);
+		remove(BENCH_COOKED_FILE);
+	}
+
+	UnloadImage(atlas);
+	for (int s = 0; s < ATLAS_REGION_COUNT; s++) {
+		UnloadImage(images[s]);
+	}
+}
+
+//------------------------------------------------------
+// Tilemap rendering, CPU quad rebuild and GPU submission to an offscreen target
+//------------------------------------------------------
+
+static void BenchWriteTileQuads(void* ctx, int i) {
+	WriteAllTileQuads(ctx);
+}
+
+typedef struct DrawBench {
+	Game* game;
+	RenderTexture2D target;
+} DrawBench;
+
+static void BenchDrawTilemap(void* ctx, int i) {
+	DrawBench* bench = ctx;
+	BeginTextureMode(bench->target);
+	BeginMode2D(bench->game->camera);
+	DrawGameTilemap(bench->game);
+	EndMode2D();
+	EndTextureMode();
+}
+
+//------------------------------------------------------
+
+int main(int argc, char** argv) {
+	bool gpu = argc > 1 && strcmp(argv[1], "--gpu") == 0;
+
+	SetTraceLogLevel(LOG_WARNING);
+	if (gpu) {
+		SetConfigFlags(FLAG_WINDOW_HIDDEN);
+		InitWindow(VIEW_WIDTH, VIEW_HEIGHT, "bench");
+		LoadAssetsGame();
+	}
+
+	const int sizes[][2] = {{80, 40}, {256, 64}, {1024, 128}};
+	for (int s = 0; s < 3; s++) {
+		Game game = NewGame(sizes[s][0], sizes[s][1], 16);
+		RunBench(TextFormat("NewLevel %dx%d", sizes[s][0], sizes[s][1]), BenchNewLevel, &game, 4);
+		DestroyGame(&game);
+	}
+
+	RunLevelFileBench(1024, 128, false);
+	RunLevelFileBench(1024, 128, true);
+	RunLevelFileBench(8192, 1024, false);
+
+	RunAtlasBench();
+
+	Game game = NewGame(256, 64, 4096);
+	NewLevelWithSeed(&game, 1);
+
+	TrajectoryBench* trajectories = MemAlloc(sizeof(TrajectoryBench));
+	LoadTrajectories(trajectories, &game, 2);
+	RunBench("PlayerMoveAndCollideX", BenchMoveX, trajectories, 1024);
+	RunBench("PlayerMoveAndCollideY", BenchMoveY, trajectories, 1024);
+
+	const int objectCounts[] = {16, 256, 4096};
+	for (int c = 0; c < 3; c++) {
+		FillObjects(&game, objectCounts[c], 3);
+		RunBench(TextFormat("GetObjectAt %d objects", objectCounts[c]), BenchGetObjectAt, trajectories, 1024);
+	}
+	MemFree(trajectories);
+
+	const int bodyCounts[] = {256, BODY_LIMIT};
+	for (int c = 0; c < 2; c++) {
+		BodyBench bodies;
+		LoadBodyBench(&bodies, &game, bodyCounts[c], 4);
+		RunBench(TextFormat("StepBodies %d bodies", bodyCounts[c]), BenchStepBodies, &bodies, BODY_BENCH_RUN);
+		MemFree(bodies.start);
+	}
+	ClearBodies(&game);
+
+	Game played = NewGame(80, 40, 16);
+	NewLevelWithSeed(&played, 1);
+	for (int x = 0; x < 64; x++) {
+		SetTileAt(&played, x, 8, TILE_ID_BLOCK); // edits the snapshot carries
+	}
+	for (int t = 0; t < 600; t++) {
+		StepGame(&played, (InputFrame){.right = true, .jumpPressed = t % 40 == 0});
+	}
+	SnapshotBench snapshots = {&played, {{0}}, 1};
+	RunBench("SnapshotGame 64 edits", BenchSnapshotGame, &snapshots, 256);
+	RunBench("RestoreGame same tick", BenchRestoreGame, &snapshots, 256);
+
+	const int replayedEdits[] = {64, 512};
+	for (int r = 0; r < 2; r++) {
+		RestoreGame(&played, &snapshots.snapshots[0]);
+		for (int e = 0; e < replayedEdits[r]; e++) {
+			int x = e % played.width, y = 2 + e / played.width;
+			SetTileAt(&played, x, y, GetTileAt(&played, x, y)->id == TILE_ID_NONE ? TILE_ID_BLOCK : TILE_ID_NONE);
+		}
+		SnapshotGame(&played, &snapshots.snapshots[1]);
+		snapshots.count = 2;
+		RunBench(TextFormat("RestoreGame %d edits replayed", replayedEdits[r]), BenchRestoreGame, &snapshots, 256);
+	}
+	RestoreGame(&played, &snapshots.snapshots[0]);
+	UnloadGameSnapshot(&snapshots.snapshots[0]);
+	UnloadGameSnapshot(&snapshots.snapshots[1]);
+
+	RunBench("StepGame", BenchStepGame, &played, 256);
+	LoadRewind(&played, REWIND_BUFFER_SIZE);
+	RunBench("StepGame + RecordRewindTick", BenchStepGameRewind, &played, 256);
+	DestroyGame(&played);
+
+	if (gpu) {
+		LoadGameRenderer(&game);
+		RunBench("WriteAllTileQuads 256x64", BenchWriteTileQuads, &game, 4);
+
+		DrawBench draw = {&game, LoadRenderTexture(VIEW_WIDTH, VIEW_HEIGHT)};
+		UpdateTileMesh(&game);
+		RunBench("DrawGameTilemap 256x64", BenchDrawTilemap, &draw, 16);
+		UnloadRenderTexture(draw.target);
+
+		UnloadGameRenderer(&game);
+	}
+
+	DestroyGame(&game);
+
+	if (gpu) {
+		UnloadAssetsGame();
+		CloseWindow();
+	}
+
+	return 0;
+}
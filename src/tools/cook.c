@@ -0,0 +1,71 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+#include "src/systems/atlas.h"
+#include "src/systems/cooked.h"
+
+#include <stdio.h>
+
+// Offline asset cooking, packs the sprite sheets into the atlas and stores it as GPU-ready
+// pixels, then lists what it wrote in a manifest. Needs no window or GL context.
+// usage: cook [output dir]   (assets/cooked by default, must exist)
+
+//------------------------------------------------------
+
+int main(int argc, char** argv) {
+	const char* outputDir = argc > 1 ? argv[1] : "assets/cooked";
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	Image images[ATLAS_REGION_COUNT];
+	uint64_t hashes[ATLAS_REGION_COUNT];
+	for (int i = 0; i < ATLAS_REGION_COUNT; i++) {
+		images[i] = LoadImage(atlasSheets[i]);
+		if (images[i].data == ((void*)0)) {
+			fprintf(stderr, "failed to load %s\n", atlasSheets[i]);
+			return 1;
+		}
+		ImageFormat(&images[i], PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+		int size = 0;
+		unsigned char* source = LoadFileData(atlasSheets[i], &size);
+		hashes[i] = HashBytes(source, size, 0);
+		UnloadFileData(source);
+	}
+
+	// same regions and padding the game would pack at startup
+	Rectangle regions[ATLAS_REGION_COUNT];
+	Image atlas = GenImageAtlas(images, ATLAS_REGION_COUNT, ATLAS_PADDING, regions);
+
+	char atlasFile[512];
+	snprintf(atlasFile, sizeof(atlasFile), "%s/%s", outputDir, GetFileName(COOKED_ATLAS));
+	bool success = SaveCookedImage(atlas, regions, ATLAS_REGION_COUNT, atlasFile);
+	if (!success) {
+		fprintf(stderr, "failed to write %s\n", atlasFile);
+	}
+
+	// The manifest doubles as the make target, it is only written once everything cooked
+	char manifestFile[512];
+	snprintf(manifestFile, sizeof(manifestFile), "%s/%s", outputDir, GetFileName(COOKED_MANIFEST));
+	FILE* manifest = success ? fopen(manifestFile, "w") : ((void*)0);
+	if (manifest != ((void*)0)) {
+		fprintf(manifest, "# cooked asset, pixel format and size, file bytes, then each source with its hash\n");
+		fprintf(manifest, "%s rgba8 %dx%d %d", GetFileName(COOKED_ATLAS), atlas.width, atlas.height, GetFileLength(atlasFile));
+		for (int i = 0; i < ATLAS_REGION_COUNT; i++) {
+			fprintf(manifest, " %s:%016llx", atlasSheets[i], (unsigned long long)hashes[i]);
+		}
+		fprintf(manifest, "\n");
+		fclose(manifest);
+
+		printf("cooked %s (%dx%d, %d bytes)\n", atlasFile, atlas.width, atlas.height, GetFileLength(atlasFile));
+	} else if (success) {
+		fprintf(stderr, "failed to write %s\n", manifestFile);
+		success = false;
+	}
+
+	UnloadImage(atlas);
+	for (int i = 0; i < ATLAS_REGION_COUNT; i++) {
+		UnloadImage(images[i]);
+	}
+
+	return success ? 0 : 1;
+}
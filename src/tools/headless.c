@@ -0,0 +1,137 @@
+#include "raylib.h"
+#include "src/game/platformer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Runs the simulation without a window or GL context, driven by a seeded bot or a replay.
+// usage: headless [--ticks N] [--seed S] [--endless] [--record file | --replay file]
+//                 [--load-level file] [--save-level file [--compact]]
+
+//------------------------------------------------------
+
+// Holds right and jumps at random, enters every door it touches
+static InputFrame NextBotInput(Rng* rng) {
+	return (InputFrame){
+		.right = true,
+		.jumpPressed = NextRngRange(rng, 30) == 0,
+		.doorPressed = true,
+	};
+}
+
+static double GetSeconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+	long long ticks = 1000000;
+	uint64_t seed = 1;
+	bool endless = false;
+	const char* recordFile = ((void*)0);
+	const char* replayFile = ((void*)0);
+	const char* loadLevelFile = ((void*)0);
+	const char* saveLevelFile = ((void*)0);
+	bool compact = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+			ticks = strtoll(argv[++i], ((void*)0), 10);
+		} else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = strtoull(argv[++i], ((void*)0), 10);
+		} else if (strcmp(argv[i], "--endless") == 0) {
+			endless = true;
+		} else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			recordFile = argv[++i];
+		} else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replayFile = argv[++i];
+		} else if (strcmp(argv[i], "--load-level") == 0 && i + 1 < argc) {
+			loadLevelFile = argv[++i];
+		} else if (strcmp(argv[i], "--save-level") == 0 && i + 1 < argc) {
+			saveLevelFile = argv[++i];
+		} else if (strcmp(argv[i], "--compact") == 0) {
+			compact = true;
+		} else {
+			fprintf(stderr,
+					"usage: %s [--ticks N] [--seed S] [--endless] [--record file | --replay file]\n"
+					"       [--load-level file] [--save-level file [--compact]]\n",
+					argv[0]);
+			return 1;
+		}
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+
+	Replay replay = {0};
+	Game game;
+	if (replayFile != ((void*)0)) {
+		if (!LoadReplay(&replay, replayFile)) {
+			fprintf(stderr, "failed to load replay %s\n", replayFile);
+			return 1;
+		}
+		game = NewGameFromReplay(&replay);
+		ticks = replay.tickCount;
+	} else {
+		int width = 80, height = 40;
+		if (loadLevelFile != ((void*)0) && !GetLevelFileSize(loadLevelFile, &width, &height)) {
+			fprintf(stderr, "failed to load level %s\n", loadLevelFile);
+			return 1;
+		}
+
+		game = endless ? NewEndlessGame(128, 40, 16) : NewGame(width, height, 16);
+		game.seededLevels = true; // the same arguments always replay the same run
+		if (loadLevelFile == ((void*)0)) {
+			NewLevelWithSeed(&game, seed);
+		} else if (!LoadLevelFile(&game, loadLevelFile)) {
+			fprintf(stderr, "failed to load level %s\n", loadLevelFile);
+			DestroyGame(&game);
+			return 1;
+		}
+
+		// the first level as it is before the run, to curate or load back later
+		if (saveLevelFile != ((void*)0) && !SaveLevelFile(&game, saveLevelFile, compact)) {
+			fprintf(stderr, "failed to save level %s\n", saveLevelFile);
+			DestroyGame(&game);
+			return 1;
+		}
+
+		if (recordFile != ((void*)0)) {
+			StartReplayRecording(&replay, &game);
+		}
+	}
+
+	Rng bot;
+	SeedRng(&bot, seed);
+
+	double start = GetSeconds();
+	for (long long t = 0; t < ticks; t++) {
+		InputFrame input = GetReplayInput(&replay, NextBotInput(&bot));
+		StepGame(&game, input);
+		if (replay.mode != REPLAY_NONE) {
+			UpdateReplay(&replay, &game, input);
+		}
+	}
+	double elapsed = GetSeconds() - start;
+
+	printf("ticks:   %lld\n", ticks);
+	printf("levels:  %d\n", game.level);
+	printf("score:   %d\n", game.score);
+	printf("hash:    %016llx\n", (unsigned long long)HashGameLevel(&game));
+	printf("time:    %.3f s (%.0f ticks/s)\n", elapsed, ticks / elapsed);
+
+	int result = 0;
+	if (replay.mode == REPLAY_RECORD && !SaveReplay(&replay, recordFile)) {
+		fprintf(stderr, "failed to save replay %s\n", recordFile);
+		result = 1;
+	} else if (replay.mode == REPLAY_PLAYBACK) {
+		printf("replay:  %d ticks out of sync, first at %d\n", replay.mismatches, replay.firstMismatch);
+		result = replay.mismatches != 0;
+	}
+
+	UnloadReplay(&replay);
+	DestroyGame(&game);
+	return result;
+}